@@ -0,0 +1,179 @@
+#include "AdmissionControl.h"
+
+AdmissionControl::AdmissionControl(const AdmissionClassLimits *classLimits)
+{
+    for (size_t i = 0; i < ADMISSION_NUMBER_OF_CLASSES; i++)
+    {
+        _classLimits[i] = classLimits[i];
+    }
+}
+
+// returns the endpoint index or -1 if all endpoints are used
+int8_t AdmissionControl::addEndpoint(const char *name, AdmissionClass admissionClass, uint8_t maxConcurrentRequests, uint8_t budget, uint16_t refillInterval)
+{
+    if (_numberOfEndpoints >= ADMISSION_MAX_ENDPOINTS)
+    {
+        Serial.println("Too many admission endpoints");
+        return -1;
+    }
+    AdmissionEndpoint &endpoint = _endpoints[_numberOfEndpoints];
+    endpoint = {};
+    endpoint.Name = name;
+    endpoint.Class = admissionClass;
+    endpoint.MaxConcurrentRequests = maxConcurrentRequests;
+    endpoint.Budget = budget;
+    endpoint.RefillInterval = refillInterval;
+    endpoint.Tokens = budget;
+    endpoint.LastRefill = millis();
+    return _numberOfEndpoints++;
+}
+
+bool AdmissionControl::admit(AsyncWebServerRequest *request, int8_t endpointIndex)
+{
+    if (!tryAdmit(request, endpointIndex))
+    {
+        reject(request, endpointIndex);
+        return false;
+    }
+    return true;
+}
+
+// admits without answering a rejected request, the caller sends the 503 with reject
+bool AdmissionControl::tryAdmit(AsyncWebServerRequest *request, int8_t endpointIndex)
+{
+    if (endpointIndex < 0)
+    {
+        return true;
+    }
+    AdmissionEndpoint &endpoint = _endpoints[endpointIndex];
+    uint8_t classIndex = (uint8_t)endpoint.Class;
+    if (!hasHeap(endpoint.Class))
+    {
+        _numberOfHeapRejections++;
+        endpoint.NumberOfRejectedRequests++;
+        return false;
+    }
+    if (endpoint.NumberOfActiveRequests >= endpoint.MaxConcurrentRequests || _numberOfActiveRequests[classIndex] >= _classLimits[classIndex].MaxConcurrentRequests || !takeToken(endpoint))
+    {
+        endpoint.NumberOfRejectedRequests++;
+        return false;
+    }
+
+    endpoint.NumberOfActiveRequests++;
+    _numberOfActiveRequests[classIndex]++;
+    endpoint.NumberOfAdmittedRequests++;
+    request->onDisconnect([this, endpointIndex]()
+                          { release(endpointIndex); });
+    return true;
+}
+
+// the handler is only called for admitted requests
+ArRequestHandlerFunction AdmissionControl::wrap(int8_t endpoint, ArRequestHandlerFunction handler)
+{
+    return [this, endpoint, handler](AsyncWebServerRequest *request)
+    {
+        if (admit(request, endpoint))
+        {
+            handler(request);
+        }
+    };
+}
+
+uint8_t AdmissionControl::getNumberOfEndpoints()
+{
+    return _numberOfEndpoints;
+}
+
+AdmissionEndpoint AdmissionControl::getEndpoint(uint8_t endpoint)
+{
+    return _endpoints[endpoint];
+}
+
+uint8_t AdmissionControl::getNumberOfActiveRequests(AdmissionClass admissionClass)
+{
+    return _numberOfActiveRequests[(uint8_t)admissionClass];
+}
+
+uint32_t AdmissionControl::getNumberOfHeapRejections()
+{
+    return _numberOfHeapRejections;
+}
+
+bool AdmissionControl::hasHeap(AdmissionClass admissionClass)
+{
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (admissionClass == AdmissionClass::EXPENSIVE)
+    {
+        return freeHeap >= ADMISSION_MIN_FREE_HEAP_EXPENSIVE && ESP.getMaxAllocHeap() >= ADMISSION_MIN_HEAP_BLOCK_EXPENSIVE;
+    }
+    return freeHeap >= ADMISSION_MIN_FREE_HEAP;
+}
+
+// token bucket, one token is added every refill interval up to the budget
+bool AdmissionControl::takeToken(AdmissionEndpoint &endpoint)
+{
+    if (endpoint.RefillInterval == 0)
+    {
+        return true;
+    }
+    uint32_t currentMillis = millis();
+    uint32_t numberOfRefills = (currentMillis - endpoint.LastRefill) / endpoint.RefillInterval;
+    if (numberOfRefills > 0)
+    {
+        endpoint.Tokens = min((uint32_t)endpoint.Budget, endpoint.Tokens + numberOfRefills);
+        endpoint.LastRefill += numberOfRefills * endpoint.RefillInterval;
+    }
+    if (endpoint.Tokens == 0)
+    {
+        return false;
+    }
+    endpoint.Tokens--;
+    return true;
+}
+
+void AdmissionControl::release(int8_t endpointIndex)
+{
+    AdmissionEndpoint &endpoint = _endpoints[endpointIndex];
+    uint8_t classIndex = (uint8_t)endpoint.Class;
+    if (endpoint.NumberOfActiveRequests > 0)
+    {
+        endpoint.NumberOfActiveRequests--;
+    }
+    if (_numberOfActiveRequests[classIndex] > 0)
+    {
+        _numberOfActiveRequests[classIndex]--;
+    }
+}
+
+void AdmissionControl::reject(AsyncWebServerRequest *request, int8_t endpointIndex)
+{
+    reject(request, _endpoints[endpointIndex]);
+}
+
+// the 503 is sent without a body to keep it cheap
+void AdmissionControl::reject(AsyncWebServerRequest *request, AdmissionEndpoint &endpoint)
+{
+    AsyncWebServerResponse *response = request->beginResponse(503);
+    response->addHeader("Retry-After", String(_classLimits[(uint8_t)endpoint.Class].RetryAfter));
+    request->send(response);
+}
+
+AdmissionGate::AdmissionGate(AdmissionControl *admissionControl, const char *uri, WebRequestMethodComposite method, int8_t endpoint)
+    : _admissionControl(admissionControl), _uri(uri), _method(method), _endpoint(endpoint)
+{
+}
+
+// called once per request with its headers, an admitted request goes on to the next handler
+bool AdmissionGate::canHandle(AsyncWebServerRequest *request) const
+{
+    if (!(request->method() & _method) || request->url() != _uri)
+    {
+        return false;
+    }
+    return !_admissionControl->tryAdmit(request, _endpoint);
+}
+
+void AdmissionGate::handleRequest(AsyncWebServerRequest *request)
+{
+    _admissionControl->reject(request, _endpoint);
+}
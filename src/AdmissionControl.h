@@ -0,0 +1,89 @@
+#ifndef AdmissionControl_h
+#define AdmissionControl_h
+
+#include "Arduino.h"
+#include <ESPAsyncWebServer.h>
+
+#define ADMISSION_MAX_ENDPOINTS 24
+#define ADMISSION_NUMBER_OF_CLASSES 2
+#define ADMISSION_MIN_FREE_HEAP 16384           // bytes, below no request is admitted
+#define ADMISSION_MIN_FREE_HEAP_EXPENSIVE 40960 // bytes, below no expensive request is admitted
+#define ADMISSION_MIN_HEAP_BLOCK_EXPENSIVE 16384 // bytes, largest free block for an expensive request
+
+// cheap requests are answered from memory, expensive requests read files or build large documents
+enum struct AdmissionClass
+{
+    CHEAP = 0,
+    EXPENSIVE = 1
+};
+
+static const char *const ADMISSION_CLASS_NAMES[] = {"Cheap", "Expensive"};
+
+// limits of one class, the retry after time is sent with the 503 response
+struct AdmissionClassLimits
+{
+    uint8_t MaxConcurrentRequests;
+    uint16_t RetryAfter; // s
+};
+
+struct AdmissionEndpoint
+{
+    const char *Name;
+    AdmissionClass Class;
+    uint8_t MaxConcurrentRequests;
+    uint8_t Budget;          // requests which could be admitted at once
+    uint16_t RefillInterval; // ms until one more request is added to the budget
+    uint8_t NumberOfActiveRequests;
+    uint8_t Tokens;
+    uint32_t LastRefill;
+    uint32_t NumberOfAdmittedRequests;
+    uint32_t NumberOfRejectedRequests;
+};
+
+// admits web requests by the concurrency limits of their endpoint and class, the request
+// budget of the endpoint and the free heap, rejected requests get a 503 with Retry-After.
+// Only used from the async tcp task, the request is released when its client disconnects.
+class AdmissionControl
+{
+public:
+    AdmissionControl(const AdmissionClassLimits *classLimits);
+    int8_t addEndpoint(const char *name, AdmissionClass admissionClass, uint8_t maxConcurrentRequests, uint8_t budget, uint16_t refillInterval);
+    bool admit(AsyncWebServerRequest *request, int8_t endpoint);
+    ArRequestHandlerFunction wrap(int8_t endpoint, ArRequestHandlerFunction handler);
+    uint8_t getNumberOfEndpoints();
+    AdmissionEndpoint getEndpoint(uint8_t endpoint);
+    uint8_t getNumberOfActiveRequests(AdmissionClass admissionClass);
+    uint32_t getNumberOfHeapRejections();
+    bool tryAdmit(AsyncWebServerRequest *request, int8_t endpoint);
+    void reject(AsyncWebServerRequest *request, int8_t endpoint);
+
+private:
+    AdmissionClassLimits _classLimits[ADMISSION_NUMBER_OF_CLASSES];
+    uint8_t _numberOfActiveRequests[ADMISSION_NUMBER_OF_CLASSES] = {};
+    AdmissionEndpoint _endpoints[ADMISSION_MAX_ENDPOINTS];
+    uint8_t _numberOfEndpoints = 0;
+    uint32_t _numberOfHeapRejections = 0;
+    bool hasHeap(AdmissionClass admissionClass);
+    bool takeToken(AdmissionEndpoint &endpoint);
+    void release(int8_t endpoint);
+    void reject(AsyncWebServerRequest *request, AdmissionEndpoint &endpoint);
+};
+
+// admits the requests of a handler registered after it when their headers are received, so the body
+// of a rejected request is never collected, applied or flashed. Admitted requests are passed on,
+// rejected requests are taken by the gate and answered with the 503 once they are received.
+class AdmissionGate : public AsyncWebHandler
+{
+public:
+    AdmissionGate(AdmissionControl *admissionControl, const char *uri, WebRequestMethodComposite method, int8_t endpoint);
+    bool canHandle(AsyncWebServerRequest *request) const override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+
+private:
+    AdmissionControl *_admissionControl;
+    const char *_uri;
+    WebRequestMethodComposite _method;
+    int8_t _endpoint;
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "AlarmRules.h"
+
+// FAI rule, number of windows threshold from the settings, see WindSpeed::evaluateWindspeed
+static const AlarmRule DEFAULT_ALARM_RULES[] = {
+    {AlarmRuleType::EXCEEDED_WINDOWS, AlarmComparison::OUTSIDE, ALARM_ACTION_SOUND | ALARM_ACTION_SNAPSHOT | ALARM_ACTION_EVENT, 0, 0, 0, 0}};
+
+AlarmRules::AlarmRules()
+{
+    setDefaultRules();
+}
+
+bool AlarmRules::isValid(const AlarmRule *rules, uint8_t numberOfRules)
+{
+    if (rules == nullptr || numberOfRules > ALARM_MAX_RULES)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < numberOfRules; i++)
+    {
+        const AlarmRule &rule = rules[i];
+        if ((uint8_t)rule.Type > (uint8_t)AlarmRuleType::EXCEEDED_WINDOWS || (uint8_t)rule.Comparison > (uint8_t)AlarmComparison::OUTSIDE)
+        {
+            return false;
+        }
+        if ((rule.Type == AlarmRuleType::DURATION || rule.Type == AlarmRuleType::RATE_OF_CHANGE) && rule.Duration == 0)
+        {
+            return false;
+        }
+        // the release threshold has to be on the other side of the threshold, otherwise the rule never releases
+        if (rule.Type == AlarmRuleType::HYSTERESIS
+            && (rule.Comparison == AlarmComparison::OUTSIDE
+                || (rule.Comparison == AlarmComparison::ABOVE && rule.ReleaseThreshold >= rule.Threshold)
+                || (rule.Comparison == AlarmComparison::BELOW && rule.ReleaseThreshold <= rule.Threshold)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AlarmRules::setRules(const AlarmRule *rules, uint8_t numberOfRules)
+{
+    if (!isValid(rules, numberOfRules))
+    {
+        return false;
+    }
+    uint8_t inactiveTable = _activeTable ^ 1;
+    for (size_t i = 0; i < numberOfRules; i++)
+    {
+        _rules[inactiveTable][i] = rules[i];
+    }
+    _numberOfRules[inactiveTable] = numberOfRules;
+    _activeTable = inactiveTable;
+    return true;
+}
+
+void AlarmRules::setDefaultRules()
+{
+    setRules(DEFAULT_ALARM_RULES, sizeof(DEFAULT_ALARM_RULES) / sizeof(AlarmRule));
+}
+
+uint8_t AlarmRules::getRules(AlarmRule *rules, uint8_t maxNumberOfRules)
+{
+    uint8_t table = _activeTable;
+    uint8_t numberOfRules = _numberOfRules[table] < maxNumberOfRules ? _numberOfRules[table] : maxNumberOfRules;
+    for (size_t i = 0; i < numberOfRules; i++)
+    {
+        rules[i] = _rules[table][i];
+    }
+    return numberOfRules;
+}
+
+void AlarmRules::setupActionCallback(std::function<void(uint8_t, const AlarmRule &)> actionCallback)
+{
+    _actionCallback = actionCallback;
+}
+
+void AlarmRules::resetStates()
+{
+    for (size_t i = 0; i < ALARM_MAX_RULES; i++)
+    {
+        _states[i].IsActive = false;
+        _states[i].Counter = 0;
+    }
+}
+
+bool AlarmRules::isRuleActive(uint8_t rule)
+{
+    return rule < ALARM_MAX_RULES && _states[rule].IsActive;
+}
+
+// rules of the last evaluation with their states, only called from the evaluating task
+uint8_t AlarmRules::getEvaluatedRules(AlarmRule *rules, bool *isActive, uint8_t maxNumberOfRules)
+{
+    uint8_t table = _evaluatedTable;
+    uint8_t numberOfRules = _numberOfRules[table] < maxNumberOfRules ? _numberOfRules[table] : maxNumberOfRules;
+    for (size_t i = 0; i < numberOfRules; i++)
+    {
+        rules[i] = _rules[table][i];
+        isActive[i] = _states[i].IsActive;
+    }
+    return numberOfRules;
+}
+
+bool AlarmRules::isConditionMet(const AlarmRule &rule, int16_t value, const AlarmInput &input)
+{
+    switch (rule.Comparison)
+    {
+    case AlarmComparison::ABOVE:
+        return value > rule.Threshold;
+    case AlarmComparison::BELOW:
+        return value < rule.Threshold;
+    default:
+        return value > input.UpperThreshold || value < input.LowerThreshold;
+    }
+}
+
+// returns true while the rule is active
+bool AlarmRules::evaluateRule(const AlarmRule &rule, AlarmRuleState &state, const AlarmInput &input)
+{
+    switch (rule.Type)
+    {
+    case AlarmRuleType::THRESHOLD:
+        return isConditionMet(rule, input.Windspeed, input);
+
+    case AlarmRuleType::DURATION:
+        if (!isConditionMet(rule, input.Windspeed, input))
+        {
+            state.Counter = 0;
+            return false;
+        }
+        if (state.Counter < rule.Duration)
+        {
+            state.Counter++;
+        }
+        return state.Counter >= rule.Duration;
+
+    case AlarmRuleType::RATE_OF_CHANGE:
+    {
+        if (input.History == nullptr || rule.Duration >= input.HistoryLength)
+        {
+            return false;
+        }
+        int16_t change = input.Windspeed - input.History[rule.Duration];
+        switch (rule.Comparison)
+        {
+        case AlarmComparison::ABOVE:
+            return change >= rule.Threshold;
+        case AlarmComparison::BELOW:
+            return -change >= rule.Threshold;
+        default:
+            return change >= rule.Threshold || -change >= rule.Threshold;
+        }
+    }
+
+    case AlarmRuleType::HYSTERESIS:
+        if (rule.Comparison == AlarmComparison::ABOVE)
+        {
+            return state.IsActive ? input.Windspeed >= rule.ReleaseThreshold : input.Windspeed > rule.Threshold;
+        }
+        return state.IsActive ? input.Windspeed <= rule.ReleaseThreshold : input.Windspeed < rule.Threshold;
+
+    case AlarmRuleType::EXCEEDED_WINDOWS:
+    {
+        uint16_t numberOfWindows = rule.Threshold > 0 ? rule.Threshold : input.NumberOfWindowsThreshold;
+        return input.NumberOfExceededRanges >= numberOfWindows;
+    }
+
+    default:
+        return false;
+    }
+}
+
+void AlarmRules::evaluate(const AlarmInput &input)
+{
+    uint8_t table = _activeTable;
+    if (table != _evaluatedTable)
+    {
+        resetStates();
+        _evaluatedTable = table;
+    }
+
+    for (size_t i = 0; i < _numberOfRules[table]; i++)
+    {
+        const AlarmRule &rule = _rules[table][i];
+        AlarmRuleState &state = _states[i];
+        bool isActive = evaluateRule(rule, state, input);
+        if (isActive && !state.IsActive && _actionCallback != nullptr)
+        {
+            _actionCallback(i, rule);
+        }
+        state.IsActive = isActive;
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef AlarmRules_h
+#define AlarmRules_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include "WindSpeedConfig.h"
+
+#define ALARM_MAX_RULES 8
+
+#define ALARM_ACTION_SOUND 0x01
+#define ALARM_ACTION_SNAPSHOT 0x02
+#define ALARM_ACTION_EVENT 0x04
+
+enum struct AlarmRuleType : uint8_t
+{
+    THRESHOLD = 0,
+    DURATION = 1,
+    RATE_OF_CHANGE = 2,
+    HYSTERESIS = 3,
+    EXCEEDED_WINDOWS = 4
+};
+
+// OUTSIDE compares against the configured lower and upper windspeed thresholds
+enum struct AlarmComparison : uint8_t
+{
+    ABOVE = 0,
+    BELOW = 1,
+    OUTSIDE = 2
+};
+
+// names used by the settings api, indexed by the enum values and action bits
+static const char *const ALARM_RULE_TYPE_NAMES[] = {"Threshold", "Duration", "RateOfChange", "Hysteresis", "ExceededWindows"};
+static const char *const ALARM_COMPARISON_NAMES[] = {"Above", "Below", "Outside"};
+static const char *const ALARM_ACTION_NAMES[] = {"Sound", "Snapshot", "Event"};
+
+// compiled rule, windspeeds in storage units (0.1 m/s), durations in samples
+struct AlarmRule
+{
+    AlarmRuleType Type;
+    AlarmComparison Comparison;
+    uint8_t Actions;
+    uint8_t SoundPattern;
+    int16_t Threshold;
+    int16_t ReleaseThreshold;
+    uint16_t Duration;
+};
+
+struct AlarmRuleState
+{
+    bool IsActive;
+    uint16_t Counter;
+};
+
+// values of the current sample the rules are evaluated against, history[0] is the current sample
+struct AlarmInput
+{
+    int16_t Windspeed;
+    int16_t LowerThreshold;
+    int16_t UpperThreshold;
+    uint16_t NumberOfExceededRanges;
+    uint16_t NumberOfWindowsThreshold;
+    const WindSpeedConfig::StorageType *History;
+    uint16_t HistoryLength;
+};
+
+// evaluates a compact table of alarm rules incrementally once per sample, the cost is
+// bounded by the number of rules. The actions of a rule are triggered once when the rule
+// becomes active and again only after it has been released. The table is double buffered,
+// so it could be replaced from another task while the sampling tick evaluates it.
+class AlarmRules
+{
+public:
+    AlarmRules();
+    bool setRules(const AlarmRule *rules, uint8_t numberOfRules);
+    void setDefaultRules();
+    uint8_t getRules(AlarmRule *rules, uint8_t maxNumberOfRules);
+    void setupActionCallback(std::function<void(uint8_t, const AlarmRule &)> actionCallback);
+    void evaluate(const AlarmInput &input);
+    bool isRuleActive(uint8_t rule);
+    uint8_t getEvaluatedRules(AlarmRule *rules, bool *isActive, uint8_t maxNumberOfRules);
+    static bool isValid(const AlarmRule *rules, uint8_t numberOfRules);
+
+private:
+    AlarmRule _rules[2][ALARM_MAX_RULES];
+    uint8_t _numberOfRules[2] = {0, 0};
+    volatile uint8_t _activeTable = 0;
+    uint8_t _evaluatedTable = 0;
+    AlarmRuleState _states[ALARM_MAX_RULES];
+    std::function<void(uint8_t, const AlarmRule &)> _actionCallback = nullptr;
+    void resetStates();
+    bool isConditionMet(const AlarmRule &rule, int16_t value, const AlarmInput &input);
+    bool evaluateRule(const AlarmRule &rule, AlarmRuleState &state, const AlarmInput &input);
+};
+
+#endif
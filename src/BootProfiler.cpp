@@ -0,0 +1,52 @@
+#include "BootProfiler.h"
+
+BootProfiler::BootProfiler()
+{
+}
+
+// returns -1 if all stages are used
+int8_t BootProfiler::beginStage(const char *name)
+{
+    uint32_t start = millis();
+    int8_t stage = -1;
+    portENTER_CRITICAL(&_lock);
+    if (_numberOfStages < BOOT_PROFILER_MAX_STAGES)
+    {
+        stage = _numberOfStages++;
+        _stages[stage] = {name, start, 0, false};
+    }
+    portEXIT_CRITICAL(&_lock);
+    return stage;
+}
+
+void BootProfiler::endStage(int8_t stage)
+{
+    uint32_t end = millis();
+    if (stage < 0)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&_lock);
+    _stages[stage].Duration = end - _stages[stage].Start;
+    _stages[stage].IsFinished = true;
+    portEXIT_CRITICAL(&_lock);
+}
+
+// stage without duration, e.g. the first sample
+void BootProfiler::mark(const char *name)
+{
+    endStage(beginStage(name));
+}
+
+uint8_t BootProfiler::getNumberOfStages()
+{
+    return _numberOfStages;
+}
+
+BootStage BootProfiler::getStage(uint8_t stage)
+{
+    portENTER_CRITICAL(&_lock);
+    BootStage bootStage = _stages[stage];
+    portEXIT_CRITICAL(&_lock);
+    return bootStage;
+}
@@ -0,0 +1,35 @@
+#ifndef BootProfiler_h
+#define BootProfiler_h
+
+#include "Arduino.h"
+
+#define BOOT_PROFILER_MAX_STAGES 16
+
+// start and duration in ms since power on
+struct BootStage
+{
+    const char *Name;
+    uint32_t Start;
+    uint32_t Duration;
+    bool IsFinished;
+};
+
+// records the durations of the boot stages, stages could be started and finished from
+// the setup and from the background boot tasks concurrently
+class BootProfiler
+{
+public:
+    BootProfiler();
+    int8_t beginStage(const char *name);
+    void endStage(int8_t stage);
+    void mark(const char *name);
+    uint8_t getNumberOfStages();
+    BootStage getStage(uint8_t stage);
+
+private:
+    BootStage _stages[BOOT_PROFILER_MAX_STAGES];
+    uint8_t _numberOfStages = 0;
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "CalibrationCurve.h"
+
+CalibrationCurve::CalibrationCurve()
+{
+    setDefaultPoints();
+}
+
+// frequencies have to be strictly and windspeeds monotonic increasing
+bool CalibrationCurve::isValid(const CalibrationPoint *points, uint8_t numberOfPoints)
+{
+    if (points == nullptr || numberOfPoints < 2 || numberOfPoints > CALIBRATION_MAX_POINTS)
+    {
+        return false;
+    }
+    for (size_t i = 1; i < numberOfPoints; i++)
+    {
+        if (points[i].Frequency <= points[i - 1].Frequency || points[i].Windspeed < points[i - 1].Windspeed)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CalibrationCurve::setPoints(const CalibrationPoint *points, uint8_t numberOfPoints)
+{
+    if (!isValid(points, numberOfPoints))
+    {
+        return false;
+    }
+    uint8_t inactiveTable = _activeTable ^ 1;
+    for (size_t i = 0; i < numberOfPoints; i++)
+    {
+        _points[inactiveTable][i] = points[i];
+    }
+    _numberOfPoints[inactiveTable] = numberOfPoints;
+    _activeTable = inactiveTable;
+    return true;
+}
+
+void CalibrationCurve::setDefaultPoints()
+{
+    setPoints(DEFAULT_CALIBRATION_POINTS, DEFAULT_CALIBRATION_NUMBER_OF_POINTS);
+}
+
+// integer factor applied on top of the curve, 0 and 1 leave the curve unchanged
+void CalibrationCurve::setCalibrationFactor(uint16_t calibrationFactor)
+{
+    _calibrationFactor = calibrationFactor == 0 ? 1 : calibrationFactor;
+}
+
+// windspeed in mm/s for a pulse frequency in mHz
+uint32_t CalibrationCurve::getWindspeed(uint32_t frequency)
+{
+    uint8_t table = _activeTable;
+    const CalibrationPoint *points = _points[table];
+    uint8_t numberOfPoints = _numberOfPoints[table];
+
+    if (frequency <= points[0].Frequency)
+    {
+        return points[0].Windspeed * _calibrationFactor;
+    }
+
+    size_t segment = 1;
+    while (segment + 1 < numberOfPoints && frequency > points[segment].Frequency)
+    {
+        segment++;
+    }
+
+    const CalibrationPoint &lower = points[segment - 1];
+    const CalibrationPoint &upper = points[segment];
+    uint64_t windspeed = lower.Windspeed + (uint64_t)(frequency - lower.Frequency) * (upper.Windspeed - lower.Windspeed) / (upper.Frequency - lower.Frequency);
+    windspeed *= _calibrationFactor;
+    return windspeed > UINT32_MAX ? UINT32_MAX : (uint32_t)windspeed;
+}
+
+uint8_t CalibrationCurve::getNumberOfPoints()
+{
+    return _numberOfPoints[_activeTable];
+}
+
+CalibrationPoint CalibrationCurve::getPoint(uint8_t index)
+{
+    uint8_t table = _activeTable;
+    if (index >= _numberOfPoints[table])
+    {
+        return CalibrationPoint{0, 0};
+    }
+    return _points[table][index];
+}
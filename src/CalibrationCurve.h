@@ -0,0 +1,45 @@
+#ifndef CalibrationCurve_h
+#define CalibrationCurve_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CALIBRATION_MAX_POINTS 16
+
+// point of the calibration curve in fixed point units
+struct CalibrationPoint
+{
+    uint32_t Frequency; // mHz
+    uint32_t Windspeed; // mm/s
+};
+
+// default sensor curve: 20 pulses per revolution, one revolution per second equals 1.75 m/s
+static constexpr CalibrationPoint DEFAULT_CALIBRATION_POINTS[] = {
+    {0, 0},
+    {1000000, 87500}};
+static constexpr uint8_t DEFAULT_CALIBRATION_NUMBER_OF_POINTS = sizeof(DEFAULT_CALIBRATION_POINTS) / sizeof(CalibrationPoint);
+
+// maps the pulse frequency to the windspeed through a piecewise linear lookup table,
+// evaluated in integer arithmetic only. Frequencies above the last point are extrapolated
+// with the slope of the last segment. The table is double buffered, so it could be replaced
+// from another task while the sampling tick evaluates it.
+class CalibrationCurve
+{
+public:
+    CalibrationCurve();
+    bool setPoints(const CalibrationPoint *points, uint8_t numberOfPoints);
+    void setDefaultPoints();
+    void setCalibrationFactor(uint16_t calibrationFactor);
+    uint32_t getWindspeed(uint32_t frequency);
+    uint8_t getNumberOfPoints();
+    CalibrationPoint getPoint(uint8_t index);
+    static bool isValid(const CalibrationPoint *points, uint8_t numberOfPoints);
+
+private:
+    CalibrationPoint _points[2][CALIBRATION_MAX_POINTS];
+    uint8_t _numberOfPoints[2] = {0, 0};
+    volatile uint8_t _activeTable = 0;
+    volatile uint16_t _calibrationFactor = 1;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "Clock.h"
+
+// positions of the fields inside the timestamp text
+#define CLOCK_YEAR_POSITION 0
+#define CLOCK_MONTH_POSITION 5
+#define CLOCK_DAY_POSITION 8
+#define CLOCK_HOUR_POSITION 11
+#define CLOCK_MINUTE_POSITION 14
+#define CLOCK_SECOND_POSITION 17
+
+Clock::Clock()
+{
+    recompute(0);
+    _isValid = false;
+}
+
+// called once per tick with the current time, a day change is reported after the update
+void Clock::update(time_t time)
+{
+    if (_isValid && time == _time)
+    {
+        return;
+    }
+    if (_isValid && time == _time + 1 && !(_dateTime.Hour == 23 && _dateTime.Minute == 59 && _dateTime.Second == 59))
+    {
+        _time = time;
+        advanceSecond();
+        return;
+    }
+
+    // day rollover or resync
+    bool isFirstUpdate = !_isValid;
+    ClockDateTime previousDateTime = _dateTime;
+    recompute(time);
+    bool isDayChanged = previousDateTime.Day != _dateTime.Day || previousDateTime.Month != _dateTime.Month || previousDateTime.Year != _dateTime.Year;
+    if (!isFirstUpdate && isDayChanged && _dayChangeCallback != nullptr)
+    {
+        _dayChangeCallback(_dateTime);
+    }
+}
+
+void Clock::setupDayChangeCallback(std::function<void(const ClockDateTime &)> dayChangeCallback)
+{
+    _dayChangeCallback = dayChangeCallback;
+}
+
+void Clock::advanceSecond()
+{
+    if (++_dateTime.Second < 60)
+    {
+        formatDigits(CLOCK_SECOND_POSITION, 2, _dateTime.Second);
+        return;
+    }
+    _dateTime.Second = 0;
+    formatDigits(CLOCK_SECOND_POSITION, 2, 0);
+    if (++_dateTime.Minute < 60)
+    {
+        formatDigits(CLOCK_MINUTE_POSITION, 2, _dateTime.Minute);
+        return;
+    }
+    _dateTime.Minute = 0;
+    formatDigits(CLOCK_MINUTE_POSITION, 2, 0);
+    _dateTime.Hour++;
+    formatDigits(CLOCK_HOUR_POSITION, 2, _dateTime.Hour);
+}
+
+void Clock::recompute(time_t time)
+{
+    _time = time;
+    _isValid = true;
+    toDateTime(time, _dateTime);
+
+    formatDigits(CLOCK_YEAR_POSITION, 4, _dateTime.Year);
+    formatDigits(CLOCK_MONTH_POSITION, 2, _dateTime.Month);
+    formatDigits(CLOCK_DAY_POSITION, 2, _dateTime.Day);
+    formatDigits(CLOCK_HOUR_POSITION, 2, _dateTime.Hour);
+    formatDigits(CLOCK_MINUTE_POSITION, 2, _dateTime.Minute);
+    formatDigits(CLOCK_SECOND_POSITION, 2, _dateTime.Second);
+    _timestamp[CLOCK_MONTH_POSITION - 1] = '-';
+    _timestamp[CLOCK_DAY_POSITION - 1] = '-';
+    _timestamp[CLOCK_HOUR_POSITION - 1] = ' ';
+    _timestamp[CLOCK_MINUTE_POSITION - 1] = ':';
+    _timestamp[CLOCK_SECOND_POSITION - 1] = ':';
+    _timestamp[CLOCK_TIMESTAMP_LENGTH] = '\0';
+
+    for (size_t i = 0; i < CLOCK_DATE_LENGTH; i++)
+    {
+        _date[i] = _timestamp[i];
+    }
+    _date[CLOCK_DATE_LENGTH] = '\0';
+}
+
+void Clock::formatDigits(size_t position, uint8_t numberOfDigits, uint16_t value)
+{
+    for (uint8_t i = numberOfDigits; i > 0; i--)
+    {
+        _timestamp[position + i - 1] = '0' + value % 10;
+        value /= 10;
+    }
+}
+
+// civil date from the days since 1970-01-01 (proleptic gregorian calendar)
+void Clock::toDateTime(time_t time, ClockDateTime &dateTime)
+{
+    int64_t seconds = time;
+    int64_t days = seconds / 86400;
+    int64_t secondsOfDay = seconds % 86400;
+    if (secondsOfDay < 0)
+    {
+        secondsOfDay += 86400;
+        days--;
+    }
+    dateTime.Hour = secondsOfDay / 3600;
+    dateTime.Minute = secondsOfDay / 60 % 60;
+    dateTime.Second = secondsOfDay % 60;
+
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+    dateTime.Day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    dateTime.Month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    dateTime.Year = yearOfEra + era * 400 + (dateTime.Month <= 2 ? 1 : 0);
+}
+
+time_t Clock::getTime() const
+{
+    return _time;
+}
+
+const ClockDateTime &Clock::getDateTime() const
+{
+    return _dateTime;
+}
+
+// YYYY-MM-DD hh:mm:ss of the last update
+const char *Clock::getTimestamp() const
+{
+    return _timestamp;
+}
+
+// YYYY-MM-DD of the last update
+const char *Clock::getDate() const
+{
+    return _date;
+}
@@ -0,0 +1,49 @@
+#ifndef Clock_h
+#define Clock_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <functional>
+
+#define CLOCK_TIMESTAMP_LENGTH 19 // YYYY-MM-DD hh:mm:ss
+#define CLOCK_DATE_LENGTH 10      // YYYY-MM-DD
+
+struct ClockDateTime
+{
+    uint16_t Year;
+    uint8_t Month;
+    uint8_t Day;
+    uint8_t Hour;
+    uint8_t Minute;
+    uint8_t Second;
+};
+
+// keeps the broken down UTC time and the formatted timestamp of the current second.
+// Advancing by one second only updates the changed fields and digits, the calendar
+// is only recomputed on a day rollover or when the time is set to another value.
+class Clock
+{
+public:
+    Clock();
+    void update(time_t time);
+    void setupDayChangeCallback(std::function<void(const ClockDateTime &)> dayChangeCallback);
+    time_t getTime() const;
+    const ClockDateTime &getDateTime() const;
+    const char *getTimestamp() const;
+    const char *getDate() const;
+    static void toDateTime(time_t time, ClockDateTime &dateTime);
+
+private:
+    time_t _time = 0;
+    bool _isValid = false;
+    ClockDateTime _dateTime = {};
+    char _timestamp[CLOCK_TIMESTAMP_LENGTH + 1] = {};
+    char _date[CLOCK_DATE_LENGTH + 1] = {};
+    std::function<void(const ClockDateTime &)> _dayChangeCallback = nullptr;
+    void recompute(time_t time);
+    void advanceSecond();
+    void formatDigits(size_t position, uint8_t numberOfDigits, uint16_t value);
+};
+
+#endif
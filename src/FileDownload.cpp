@@ -0,0 +1,74 @@
+#include "FileDownload.h"
+
+FileDownload::FileDownload(SpiBus *spiBus)
+{
+    _spiBus = spiBus;
+}
+
+FileDownload::~FileDownload()
+{
+    if (_file)
+    {
+        SpiBusLock lock(_spiBus, SpiBusPriority::DOWNLOAD, FILE_DOWNLOAD_OPEN_TIMEOUT);
+        _file.close();
+    }
+    free(_chunk);
+}
+
+bool FileDownload::open(fs::FS &fs, const char *path)
+{
+    TRACE_SPAN("download_open");
+    _chunk = (uint8_t *)malloc(FILE_DOWNLOAD_CHUNK_SIZE);
+    if (_chunk == nullptr)
+    {
+        Serial.println("Failed to allocate download buffer");
+        return false;
+    }
+    SpiBusLock lock(_spiBus, SpiBusPriority::DOWNLOAD, FILE_DOWNLOAD_OPEN_TIMEOUT);
+    if (!lock.isAcquired())
+    {
+        return false;
+    }
+    _file = fs.open(path, FILE_READ);
+    if (!_file || _file.isDirectory())
+    {
+        _file = File();
+        return false;
+    }
+    _size = _file.size();
+    return true;
+}
+
+size_t FileDownload::getSize()
+{
+    return _size;
+}
+
+// index is the number of bytes already sent, the file is read sequentially
+size_t FileDownload::read(uint8_t *buffer, size_t maxLength, size_t index)
+{
+    if (index >= _size)
+    {
+        return 0;
+    }
+    if (index >= _chunkStart + _chunkLength)
+    {
+        TRACE_SPAN("download_chunk");
+        SpiBusLock lock(_spiBus, SpiBusPriority::DOWNLOAD, FILE_DOWNLOAD_READ_TIMEOUT);
+        if (!lock.isAcquired())
+        {
+            return RESPONSE_TRY_AGAIN;
+        }
+        _chunkStart += _chunkLength;
+        _chunkLength = _file.read(_chunk, FILE_DOWNLOAD_CHUNK_SIZE);
+        if (_chunkLength == 0)
+        {
+            Serial.println("Failed to read download chunk");
+            return 0;
+        }
+    }
+    size_t offset = index - _chunkStart;
+    size_t length = min(maxLength, _chunkLength - offset);
+    memcpy(buffer, _chunk + offset, length);
+    return length;
+}
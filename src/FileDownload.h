@@ -0,0 +1,34 @@
+#ifndef FileDownload_h
+#define FileDownload_h
+
+#include "Arduino.h"
+#include <FS.h>
+#include <ESPAsyncWebServer.h>
+#include "SpiBus.h"
+#include "Tracer.h"
+
+#define FILE_DOWNLOAD_CHUNK_SIZE 4096 // bytes, multiple of the sd card sector size
+#define FILE_DOWNLOAD_OPEN_TIMEOUT 1000 // ms
+#define FILE_DOWNLOAD_READ_TIMEOUT 10   // ms, the response is retried if the bus is busy
+
+// reads a file of the sd card in aligned chunks for a response with known length, the
+// spi bus is only held while one chunk is read, so logging and display are not blocked
+class FileDownload
+{
+public:
+    FileDownload(SpiBus *spiBus);
+    ~FileDownload();
+    bool open(fs::FS &fs, const char *path);
+    size_t getSize();
+    size_t read(uint8_t *buffer, size_t maxLength, size_t index);
+
+private:
+    SpiBus *_spiBus;
+    File _file;
+    size_t _size = 0;
+    uint8_t *_chunk = nullptr;
+    size_t _chunkStart = 0;
+    size_t _chunkLength = 0;
+};
+
+#endif
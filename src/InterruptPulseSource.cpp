@@ -0,0 +1,39 @@
+#include "InterruptPulseSource.h"
+
+InterruptPulseSource::InterruptPulseSource(uint8_t sensorPin)
+{
+    _sensorPin = sensorPin;
+}
+
+void InterruptPulseSource::begin()
+{
+    pinMode(_sensorPin, INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(_sensorPin), interruptCallback, this, RISING);
+}
+
+uint32_t InterruptPulseSource::getCount()
+{
+    return _counter;
+}
+
+void InterruptPulseSource::setupPulseCapture(PulseCapture *pulseCapture)
+{
+    _pulseCapture = pulseCapture;
+}
+
+bool InterruptPulseSource::hasEdgeTimestamps()
+{
+    return true;
+}
+
+// interrupt callback function for impuls counter of windspeed sensor, has to stay in IRAM
+// as the gpio isr service is allowed to run while the flash cache is disabled
+void IRAM_ATTR InterruptPulseSource::interruptCallback(void *arg)
+{
+    InterruptPulseSource *pulseSource = (InterruptPulseSource *)arg;
+    pulseSource->_counter++;
+    if (pulseSource->_pulseCapture != nullptr)
+    {
+        pulseSource->_pulseCapture->recordEdge(micros());
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef InterruptPulseSource_h
+#define InterruptPulseSource_h
+
+#include "Arduino.h"
+#include "PulseSource.h"
+
+// counts the pulses with a gpio interrupt per rising edge and forwards the edge timestamps
+class InterruptPulseSource : public PulseSource
+{
+public:
+    InterruptPulseSource(uint8_t sensorPin);
+    void begin() override;
+    uint32_t getCount() override;
+    void setupPulseCapture(PulseCapture *pulseCapture) override;
+    bool hasEdgeTimestamps() override;
+
+private:
+    uint8_t _sensorPin;
+    volatile uint32_t _counter = 0;
+    PulseCapture *_pulseCapture = nullptr;
+    static void interruptCallback(void *arg);
+};
+
+#endif
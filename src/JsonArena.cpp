@@ -0,0 +1,261 @@
+#include "JsonArena.h"
+
+JsonArenaPool jsonArenaPool;
+
+// used by the leases if all arenas are taken
+static JsonArena heapAllocator;
+
+static inline size_t alignSize(size_t size)
+{
+    return (size + JSON_ARENA_ALIGNMENT - 1) & ~(size_t)(JSON_ARENA_ALIGNMENT - 1);
+}
+
+JsonArena::JsonArena()
+{
+}
+
+bool JsonArena::setup(size_t size, bool usePsram)
+{
+    _buffer = (uint8_t *)heap_caps_malloc(size, usePsram ? MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT : MALLOC_CAP_8BIT);
+    _size = _buffer != nullptr ? size : 0;
+    reset();
+    return _buffer != nullptr;
+}
+
+void *JsonArena::allocate(size_t size)
+{
+    size_t capacity = alignSize(size);
+    if (_buffer != nullptr && _size - _used >= capacity + JSON_ARENA_HEADER_SIZE)
+    {
+        uint8_t *block = _buffer + _used + JSON_ARENA_HEADER_SIZE;
+        *(size_t *)(block - JSON_ARENA_HEADER_SIZE) = capacity;
+        _used += capacity + JSON_ARENA_HEADER_SIZE;
+        if (_used > _peakUsage)
+        {
+            _peakUsage = _used;
+        }
+        _lastBlock = block;
+        return block;
+    }
+    if (_buffer != nullptr)
+    {
+        _numberOfFallbacks++;
+    }
+    return malloc(size);
+}
+
+// only the last block is given back immediately, all others with the reset
+void JsonArena::deallocate(void *pointer)
+{
+    if (!contains(pointer))
+    {
+        free(pointer);
+        return;
+    }
+    if (pointer == _lastBlock)
+    {
+        _used = _lastBlock - JSON_ARENA_HEADER_SIZE - _buffer;
+        _lastBlock = nullptr;
+    }
+}
+
+// the last block grows in place, strings are built this way
+void *JsonArena::reallocate(void *pointer, size_t newSize)
+{
+    if (pointer == nullptr)
+    {
+        return allocate(newSize);
+    }
+    if (!contains(pointer))
+    {
+        return realloc(pointer, newSize);
+    }
+
+    size_t capacity = getCapacity(pointer);
+    size_t newCapacity = alignSize(newSize);
+    if (pointer == _lastBlock && (size_t)(_lastBlock - _buffer) + newCapacity <= _size)
+    {
+        *(size_t *)(_lastBlock - JSON_ARENA_HEADER_SIZE) = newCapacity;
+        _used = _lastBlock - _buffer + newCapacity;
+        if (_used > _peakUsage)
+        {
+            _peakUsage = _used;
+        }
+        return pointer;
+    }
+    if (newCapacity <= capacity)
+    {
+        return pointer;
+    }
+
+    void *newPointer = allocate(newSize);
+    if (newPointer != nullptr)
+    {
+        memcpy(newPointer, pointer, capacity);
+        deallocate(pointer);
+    }
+    return newPointer;
+}
+
+// all blocks are given back in one step, the blocks on the heap have been freed by the document
+void JsonArena::reset()
+{
+    _used = 0;
+    _lastBlock = nullptr;
+}
+
+size_t JsonArena::getPeakUsage()
+{
+    return _peakUsage;
+}
+
+uint32_t JsonArena::getNumberOfFallbacks()
+{
+    return _numberOfFallbacks;
+}
+
+bool JsonArena::contains(void *pointer)
+{
+    return _buffer != nullptr && (uint8_t *)pointer >= _buffer && (uint8_t *)pointer < _buffer + _size;
+}
+
+size_t JsonArena::getCapacity(void *pointer)
+{
+    return *(size_t *)((uint8_t *)pointer - JSON_ARENA_HEADER_SIZE);
+}
+
+JsonArenaPool::JsonArenaPool()
+{
+}
+
+// the arenas are placed in psram if available
+void JsonArenaPool::setup()
+{
+    _isPsram = psramFound();
+    _arenaSize = _isPsram ? JSON_ARENA_SIZE : JSON_ARENA_INTERNAL_SIZE;
+    _numberOfArenas = 0;
+    for (uint8_t i = 0; i < JSON_ARENA_POOL_SIZE; i++)
+    {
+        if (!_arenas[i].setup(_arenaSize, _isPsram))
+        {
+            Serial.println("Json arena allocation failed");
+            break;
+        }
+        _numberOfArenas++;
+    }
+}
+
+// returns nullptr if all arenas are leased
+JsonArena *JsonArenaPool::acquire()
+{
+    JsonArena *arena = nullptr;
+    portENTER_CRITICAL(&_lock);
+    _numberOfLeases++;
+    for (uint8_t i = 0; i < _numberOfArenas; i++)
+    {
+        if (!_isLeased[i])
+        {
+            _isLeased[i] = true;
+            arena = &_arenas[i];
+            break;
+        }
+    }
+    if (arena == nullptr)
+    {
+        _numberOfMissingArenas++;
+    }
+    portEXIT_CRITICAL(&_lock);
+    return arena;
+}
+
+void JsonArenaPool::release(JsonArena *arena)
+{
+    if (arena == nullptr)
+    {
+        return;
+    }
+    arena->reset();
+    portENTER_CRITICAL(&_lock);
+    _isLeased[arena - _arenas] = false;
+    portEXIT_CRITICAL(&_lock);
+}
+
+JsonArenaStatistics JsonArenaPool::getStatistics()
+{
+    JsonArenaStatistics statistics = {_numberOfArenas, _arenaSize, _isPsram, _numberOfLeases, _numberOfMissingArenas, 0, 0};
+    for (uint8_t i = 0; i < _numberOfArenas; i++)
+    {
+        statistics.NumberOfFallbacks += _arenas[i].getNumberOfFallbacks();
+        statistics.PeakUsage = max(statistics.PeakUsage, (uint32_t)_arenas[i].getPeakUsage());
+    }
+    return statistics;
+}
+
+JsonArenaLease::JsonArenaLease(JsonArenaPool &pool) : _pool(pool)
+{
+    _arena = _pool.acquire();
+}
+
+JsonArenaLease::~JsonArenaLease()
+{
+    _pool.release(_arena);
+}
+
+ArduinoJson::Allocator *JsonArenaLease::getAllocator()
+{
+    return _arena != nullptr ? _arena : &heapAllocator;
+}
+
+JsonArenaDocument::JsonArenaDocument(JsonArenaPool &pool) : _lease(pool), _document(_lease.getAllocator())
+{
+}
+
+JsonArenaDocument::~JsonArenaDocument()
+{
+    if (_json != nullptr)
+    {
+        _lease.getAllocator()->deallocate(_json);
+    }
+}
+
+JsonDocument &JsonArenaDocument::getDocument()
+{
+    return _document;
+}
+
+// length of the serialized json, 0 if there is no memory for it, the document is cleared afterwards
+// so a document on the heap (all arenas leased) does not stay allocated while the response is sent
+size_t JsonArenaDocument::serialize()
+{
+    size_t length = measureJson(_document);
+    _json = (char *)_lease.getAllocator()->allocate(length + 1);
+    if (_json == nullptr)
+    {
+        return 0;
+    }
+    _length = serializeJson(_document, _json, length + 1);
+    _document.clear();
+    return _length;
+}
+
+// copies the next part of the serialized json into the buffer of the response
+size_t JsonArenaDocument::read(uint8_t *buffer, size_t maxLength, size_t index)
+{
+    if (index >= _length)
+    {
+        return 0;
+    }
+    size_t length = min(maxLength, _length - index);
+    memcpy(buffer, _json + index, length);
+    return length;
+}
+
+const char *JsonArenaDocument::getJson()
+{
+    return _json;
+}
+
+size_t JsonArenaDocument::getLength()
+{
+    return _length;
+}
@@ -0,0 +1,106 @@
+#ifndef JsonArena_h
+#define JsonArena_h
+
+#include "Arduino.h"
+#include <ArduinoJson.h>
+
+#define JSON_ARENA_POOL_SIZE 2          // arenas for concurrently built documents
+#define JSON_ARENA_SIZE 32768           // bytes per arena in psram
+#define JSON_ARENA_INTERNAL_SIZE 8192   // bytes per arena without psram
+#define JSON_ARENA_ALIGNMENT 8
+#define JSON_ARENA_HEADER_SIZE JSON_ARENA_ALIGNMENT // capacity of the block in front of every block
+
+struct JsonArenaStatistics
+{
+    uint8_t NumberOfArenas;
+    uint32_t ArenaSize;
+    bool IsPsram;
+    uint32_t NumberOfLeases;
+    uint32_t NumberOfMissingArenas; // leases without a free arena
+    uint32_t NumberOfFallbacks;     // allocations that did not fit into the arena
+    uint32_t PeakUsage;
+};
+
+// bump allocator for ArduinoJson documents, blocks are only given back all at once with reset,
+// allocations which do not fit anymore fall back to the heap, without a buffer it is a plain heap allocator
+class JsonArena : public ArduinoJson::Allocator
+{
+public:
+    JsonArena();
+    bool setup(size_t size, bool usePsram);
+    void *allocate(size_t size) override;
+    void deallocate(void *pointer) override;
+    void *reallocate(void *pointer, size_t newSize) override;
+    void reset();
+    size_t getPeakUsage();
+    uint32_t getNumberOfFallbacks();
+
+private:
+    uint8_t *_buffer = nullptr;
+    size_t _size = 0;
+    size_t _used = 0;
+    size_t _peakUsage = 0;
+    uint8_t *_lastBlock = nullptr;
+    uint32_t _numberOfFallbacks = 0;
+    bool contains(void *pointer);
+    size_t getCapacity(void *pointer);
+};
+
+// fixed set of arenas allocated once at the start, so the json documents of the web
+// requests do not fragment the heap
+class JsonArenaPool
+{
+public:
+    JsonArenaPool();
+    void setup();
+    JsonArena *acquire();
+    void release(JsonArena *arena);
+    JsonArenaStatistics getStatistics();
+
+private:
+    JsonArena _arenas[JSON_ARENA_POOL_SIZE];
+    bool _isLeased[JSON_ARENA_POOL_SIZE] = {};
+    uint8_t _numberOfArenas = 0;
+    uint32_t _arenaSize = 0;
+    bool _isPsram = false;
+    uint32_t _numberOfLeases = 0;
+    uint32_t _numberOfMissingArenas = 0;
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+};
+
+// leases an arena for its lifetime, has to be declared before the document which uses the allocator
+class JsonArenaLease
+{
+public:
+    JsonArenaLease(JsonArenaPool &pool);
+    ~JsonArenaLease();
+    ArduinoJson::Allocator *getAllocator();
+
+private:
+    JsonArenaPool &_pool;
+    JsonArena *_arena;
+};
+
+// document in a leased arena which is serialized into the same arena, a response is sent from the
+// serialized json and the arena is given back in one step when the document is destroyed
+class JsonArenaDocument
+{
+public:
+    JsonArenaDocument(JsonArenaPool &pool);
+    ~JsonArenaDocument();
+    JsonDocument &getDocument();
+    size_t serialize();
+    size_t read(uint8_t *buffer, size_t maxLength, size_t index);
+    const char *getJson();
+    size_t getLength();
+
+private:
+    JsonArenaLease _lease;
+    JsonDocument _document;
+    char *_json = nullptr;
+    size_t _length = 0;
+};
+
+extern JsonArenaPool jsonArenaPool;
+
+#endif
@@ -0,0 +1,58 @@
+#include "Metrics.h"
+
+Metrics::Metrics()
+{
+}
+
+LatencyHistogram Metrics::getHistogram(MetricsTiming timing)
+{
+    return _histograms[(uint8_t)timing];
+}
+
+// upper bound of a bucket in us, 0 for the unbounded bucket
+uint32_t Metrics::getBucketBound(uint8_t bucket)
+{
+    if (bucket >= METRICS_HISTOGRAM_BUCKETS - 1)
+    {
+        return 0;
+    }
+    return (uint32_t)1 << (METRICS_HISTOGRAM_MIN_BOUND_SHIFT + bucket);
+}
+
+// prometheus text format, the histograms are cumulative and in seconds
+void Metrics::printPrometheus(Print &output)
+{
+    for (uint8_t i = 0; i < METRICS_NUMBER_OF_TIMINGS; i++)
+    {
+        LatencyHistogram histogram = _histograms[i];
+        const char *name = METRICS_TIMING_NAMES[i];
+        output.printf("# HELP fxwind_%s_duration_seconds Duration of %s\n", name, name);
+        output.printf("# TYPE fxwind_%s_duration_seconds histogram\n", name);
+        uint32_t count = 0;
+        for (uint8_t bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS; bucket++)
+        {
+            count += histogram.Counts[bucket];
+            uint32_t bound = getBucketBound(bucket);
+            if (bound > 0)
+            {
+                output.printf("fxwind_%s_duration_seconds_bucket{le=\"%.6f\"} %u\n", name, bound / 1000000.0, count);
+            }
+            else
+            {
+                output.printf("fxwind_%s_duration_seconds_bucket{le=\"+Inf\"} %u\n", name, count);
+            }
+        }
+        output.printf("fxwind_%s_duration_seconds_sum %.6f\n", name, histogram.Sum / 1000000.0);
+        output.printf("fxwind_%s_duration_seconds_count %u\n", name, count);
+        output.printf("# HELP fxwind_%s_duration_max_seconds Longest duration of %s\n", name, name);
+        output.printf("# TYPE fxwind_%s_duration_max_seconds gauge\n", name);
+        output.printf("fxwind_%s_duration_max_seconds %.6f\n", name, histogram.Max / 1000000.0);
+    }
+}
+
+void Metrics::printPrometheusValue(Print &output, const char *name, const char *type, const char *help, double value)
+{
+    output.printf("# HELP %s %s\n", name, help);
+    output.printf("# TYPE %s %s\n", name, type);
+    output.printf("%s %.10g\n", name, value);
+}
@@ -0,0 +1,93 @@
+#ifndef Metrics_h
+#define Metrics_h
+
+#include "Arduino.h"
+
+#define METRICS_HISTOGRAM_BUCKETS 17     // bucket i counts durations below 16us << i, the last bucket is unbounded
+#define METRICS_HISTOGRAM_MIN_BOUND_SHIFT 4 // 16us
+
+enum struct MetricsTiming
+{
+    LOOP = 0,
+    CALCULATE_WINDSPEED = 1,
+    SD_APPEND = 2,
+    DISPLAY_DRAW = 3,
+    WEB_HANDLER = 4
+};
+
+#define METRICS_NUMBER_OF_TIMINGS 5
+
+// metric names of the timings, indexed by MetricsTiming
+static const char *const METRICS_TIMING_NAMES[] = {"loop", "calculate_windspeed", "sd_append", "display_draw", "web_handler"};
+
+// durations in us
+struct LatencyHistogram
+{
+    uint32_t Counts[METRICS_HISTOGRAM_BUCKETS];
+    uint32_t Count;
+    uint64_t Sum;
+    uint32_t Max;
+};
+
+// fixed bucket latency histograms and sample counters. Recording only increments a few
+// counters, so it stays enabled in production. Every timing has to be recorded from one
+// task only, readers could see a histogram which is one record behind.
+class Metrics
+{
+public:
+    Metrics();
+    inline void record(MetricsTiming timing, uint32_t duration)
+    {
+        LatencyHistogram &histogram = _histograms[(uint8_t)timing];
+        histogram.Counts[getBucket(duration)]++;
+        histogram.Count++;
+        histogram.Sum += duration;
+        if (duration > histogram.Max)
+        {
+            histogram.Max = duration;
+        }
+    }
+    LatencyHistogram getHistogram(MetricsTiming timing);
+    void printPrometheus(Print &output);
+    static void printPrometheusValue(Print &output, const char *name, const char *type, const char *help, double value);
+    static uint32_t getBucketBound(uint8_t bucket);
+
+private:
+    LatencyHistogram _histograms[METRICS_NUMBER_OF_TIMINGS] = {};
+    static inline uint8_t getBucket(uint32_t duration)
+    {
+        uint32_t scaledDuration = duration >> METRICS_HISTOGRAM_MIN_BOUND_SHIFT;
+        if (scaledDuration == 0)
+        {
+            return 0;
+        }
+        uint8_t bucket = 32 - __builtin_clz(scaledDuration);
+        return bucket < METRICS_HISTOGRAM_BUCKETS - 1 ? bucket : METRICS_HISTOGRAM_BUCKETS - 1;
+    }
+};
+
+// records the lifetime of the timer, without metrics nothing is recorded
+class MetricsTimer
+{
+public:
+    MetricsTimer(Metrics *metrics, MetricsTiming timing)
+    {
+        _metrics = metrics;
+        _timing = timing;
+        _start = micros();
+    }
+    ~MetricsTimer()
+    {
+        if (_metrics != nullptr)
+        {
+            _metrics->record(_timing, micros() - _start);
+        }
+    }
+
+private:
+    Metrics *_metrics;
+    MetricsTiming _timing;
+    uint32_t _start;
+};
+
+#endif
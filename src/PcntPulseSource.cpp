@@ -0,0 +1,76 @@
+#include "PcntPulseSource.h"
+
+PcntPulseSource::PcntPulseSource(uint8_t sensorPin, pcnt_unit_t unit, uint16_t filterValue)
+{
+    _sensorPin = sensorPin;
+    _unit = unit;
+    _filterValue = filterValue;
+}
+
+void PcntPulseSource::begin()
+{
+    pinMode(_sensorPin, INPUT_PULLUP);
+
+    pcnt_config_t config = {};
+    config.pulse_gpio_num = _sensorPin;
+    config.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+    config.channel = PCNT_CHANNEL_0;
+    config.unit = _unit;
+    config.pos_mode = PCNT_COUNT_INC;
+    config.neg_mode = PCNT_COUNT_DIS;
+    config.lctrl_mode = PCNT_MODE_KEEP;
+    config.hctrl_mode = PCNT_MODE_KEEP;
+    config.counter_h_lim = PCNT_HIGH_LIMIT;
+    config.counter_l_lim = 0;
+
+    if (pcnt_unit_config(&config) != ESP_OK)
+    {
+        Serial.println("PCNT unit config failed");
+        return;
+    }
+
+    pcnt_set_filter_value(_unit, _filterValue);
+    pcnt_filter_enable(_unit);
+    pcnt_event_enable(_unit, PCNT_EVT_H_LIM);
+    pcnt_counter_pause(_unit);
+    pcnt_counter_clear(_unit);
+
+    // service may already be installed by another unit
+    esp_err_t result = pcnt_isr_service_install(ESP_INTR_FLAG_IRAM);
+    if (result != ESP_OK && result != ESP_ERR_INVALID_STATE)
+    {
+        Serial.println("PCNT isr service install failed");
+        return;
+    }
+    pcnt_isr_handler_add(_unit, overflowCallback, this);
+    pcnt_counter_resume(_unit);
+}
+
+// the hardware counter is reset to zero when it reaches the high limit
+void IRAM_ATTR PcntPulseSource::overflowCallback(void *arg)
+{
+    PcntPulseSource *pulseSource = (PcntPulseSource *)arg;
+    pulseSource->_overflowCounter++;
+}
+
+uint32_t PcntPulseSource::getCount()
+{
+    uint32_t overflowCounter;
+    int16_t counterValue;
+    do
+    {
+        overflowCounter = _overflowCounter;
+        pcnt_get_counter_value(_unit, &counterValue);
+    } while (overflowCounter != _overflowCounter);
+
+    uint32_t count = overflowCounter * PCNT_HIGH_LIMIT + (uint16_t)counterValue;
+
+    // the counter may already be reset while the overflow interrupt is still pending,
+    // the missing pulses are reported with the next call instead
+    if ((int32_t)(count - _lastCount) < 0)
+    {
+        return _lastCount;
+    }
+    _lastCount = count;
+    return count;
+}
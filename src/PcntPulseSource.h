@@ -0,0 +1,30 @@
+#ifndef PcntPulseSource_h
+#define PcntPulseSource_h
+
+#include "Arduino.h"
+#include <driver/pcnt.h>
+#include "PulseSource.h"
+
+#define PCNT_HIGH_LIMIT 30000
+#define PCNT_FILTER_VALUE 1023 // APB clock cycles, 1023 is the hardware maximum of ~12.8us
+
+// counts the pulses with the ESP32 pulse counter peripheral, so no cpu time is spent per pulse
+// and counting continues while the flash cache is disabled. Only the counter overflow at
+// PCNT_HIGH_LIMIT raises an interrupt. No edge timestamps are available from this source.
+class PcntPulseSource : public PulseSource
+{
+public:
+    PcntPulseSource(uint8_t sensorPin, pcnt_unit_t unit = PCNT_UNIT_0, uint16_t filterValue = PCNT_FILTER_VALUE);
+    void begin() override;
+    uint32_t getCount() override;
+
+private:
+    uint8_t _sensorPin;
+    pcnt_unit_t _unit;
+    uint16_t _filterValue;
+    volatile uint32_t _overflowCounter = 0;
+    uint32_t _lastCount = 0;
+    static void overflowCallback(void *arg);
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef Published_h
+#define Published_h
+
+#include <stdint.h>
+#include <atomic>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#define PUBLISHED_RETRY_WAIT() vTaskDelay(1)
+#else
+#include <thread>
+#define PUBLISHED_RETRY_WAIT() std::this_thread::yield()
+#endif
+
+// value published by a single writer task and read lock-free by any number of reader
+// tasks (sequence lock), a reader retries if the value was changed while it was copied
+template <typename T>
+class Published
+{
+public:
+    void publish(const T &value)
+    {
+        beginWrite() = value;
+        endWrite();
+    }
+
+    // in place update of large values, the value is published with endWrite
+    T &beginWrite()
+    {
+        uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return _value;
+    }
+
+    void endWrite()
+    {
+        _sequence.store(_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    T read() const
+    {
+        T value;
+        while (true)
+        {
+            uint32_t sequence = _sequence.load(std::memory_order_acquire);
+            if ((sequence & 1) == 0)
+            {
+                value = _value;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (_sequence.load(std::memory_order_relaxed) == sequence)
+                {
+                    return value;
+                }
+            }
+            // the writer could be preempted by this reader on the same core
+            PUBLISHED_RETRY_WAIT();
+        }
+    }
+
+    // number of published values
+    uint32_t getCount() const
+    {
+        return _sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    T _value = T();
+    std::atomic<uint32_t> _sequence{0};
+};
+
+#endif
@@ -0,0 +1,238 @@
+#include "PulseCapture.h"
+
+PulseCapture::PulseCapture(CalibrationCurve *calibrationCurve, uint32_t minimumPeriod)
+{
+    static_assert((PULSE_CAPTURE_BUFFER_SIZE & (PULSE_CAPTURE_BUFFER_SIZE - 1)) == 0, "PULSE_CAPTURE_BUFFER_SIZE must be a power of two");
+    _minimumPeriod = minimumPeriod;
+    _calibrationCurve = calibrationCurve;
+    reset();
+}
+
+// producer side, called from the interrupt with the edge timestamp in us
+void IRAM_ATTR PulseCapture::recordEdge(uint32_t timestamp)
+{
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) >= PULSE_CAPTURE_BUFFER_SIZE)
+    {
+        _overrunCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    _buffer[head & (PULSE_CAPTURE_BUFFER_SIZE - 1)] = timestamp;
+    _head.store(head + 1, std::memory_order_release);
+}
+
+// consumer side, drains all recorded edges and closes the peak ranges up to timestamp
+void PulseCapture::process(uint32_t timestamp)
+{
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    uint32_t head = _head.load(std::memory_order_acquire);
+    while (tail != head)
+    {
+        addEdge(_buffer[tail & (PULSE_CAPTURE_BUFFER_SIZE - 1)]);
+        tail++;
+        _tail.store(tail, std::memory_order_release);
+    }
+    closeBuckets(timestamp);
+}
+
+void PulseCapture::reset()
+{
+    _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+    _hasLastEdge = false;
+    _lastPeriod = 0;
+    _hasBucketStart = false;
+    _bucketIndex = 0;
+    _numberOfClosedBuckets = 0;
+    clearBucket(_currentBucket);
+    for (size_t i = 0; i < PULSE_CAPTURE_GUST_BUCKETS; i++)
+    {
+        clearBucket(_buckets[i]);
+    }
+    resetPeaks();
+}
+
+void PulseCapture::resetPeaks()
+{
+    _peakFrequency = 0;
+    _gustFrequency = 0;
+}
+
+void PulseCapture::addEdge(uint32_t timestamp)
+{
+    closeBuckets(timestamp);
+
+    if (_hasLastEdge && timestamp - _lastEdge < _minimumPeriod)
+    {
+        _glitchCount++;
+        return;
+    }
+
+    if (_currentBucket.Count == 0)
+    {
+        _currentBucket.FirstEdge = timestamp;
+        _currentBucket.ReferenceEdge = _lastEdge;
+        _currentBucket.HasReferenceEdge = _hasLastEdge;
+    }
+    _currentBucket.Count++;
+    _currentBucket.LastEdge = timestamp;
+    _edgeCount++;
+
+    _lastPeriod = _hasLastEdge ? timestamp - _lastEdge : 0;
+    _lastEdge = timestamp;
+    _hasLastEdge = true;
+}
+
+void PulseCapture::closeBuckets(uint32_t timestamp)
+{
+    if (!_hasBucketStart)
+    {
+        _bucketStart = timestamp;
+        _hasBucketStart = true;
+        return;
+    }
+
+    // edges drained late may belong to an already closed range
+    if ((int32_t)(timestamp - _bucketStart) < 0)
+    {
+        return;
+    }
+
+    // after a long calm period all buckets are empty anyway, so skip ahead
+    if (timestamp - _bucketStart > (PULSE_CAPTURE_GUST_BUCKETS + 1) * PULSE_CAPTURE_PEAK_RANGE)
+    {
+        closeBucket();
+        for (size_t i = 0; i < PULSE_CAPTURE_GUST_BUCKETS; i++)
+        {
+            clearBucket(_buckets[i]);
+        }
+        _numberOfClosedBuckets = PULSE_CAPTURE_GUST_BUCKETS;
+        _bucketStart = timestamp;
+        return;
+    }
+
+    while (timestamp - _bucketStart >= PULSE_CAPTURE_PEAK_RANGE)
+    {
+        closeBucket();
+        _bucketStart += PULSE_CAPTURE_PEAK_RANGE;
+    }
+}
+
+void PulseCapture::closeBucket()
+{
+    _buckets[_bucketIndex] = _currentBucket;
+    _bucketIndex = (_bucketIndex + 1) % PULSE_CAPTURE_GUST_BUCKETS;
+    clearBucket(_currentBucket);
+
+    PulseBucket &closedBucket = _buckets[(_bucketIndex + PULSE_CAPTURE_GUST_BUCKETS - 1) % PULSE_CAPTURE_GUST_BUCKETS];
+    uint32_t peakFrequency = getFrequency(closedBucket.Count, closedBucket.FirstEdge, closedBucket.LastEdge, closedBucket.ReferenceEdge, closedBucket.HasReferenceEdge);
+    if (peakFrequency > _peakFrequency)
+    {
+        _peakFrequency = peakFrequency;
+    }
+
+    // mean over the whole gust range, so a short burst is not reported as gust,
+    // the range is only complete once all of its buckets have been closed since the reset
+    if (_numberOfClosedBuckets < PULSE_CAPTURE_GUST_BUCKETS)
+    {
+        _numberOfClosedBuckets++;
+    }
+    if (_numberOfClosedBuckets < PULSE_CAPTURE_GUST_BUCKETS)
+    {
+        return;
+    }
+    uint32_t count = 0;
+    for (size_t i = 0; i < PULSE_CAPTURE_GUST_BUCKETS; i++)
+    {
+        count += _buckets[i].Count;
+    }
+    uint32_t gustFrequency = (uint32_t)((uint64_t)count * 1000000000ULL / (PULSE_CAPTURE_GUST_BUCKETS * PULSE_CAPTURE_PEAK_RANGE));
+    if (gustFrequency > _gustFrequency)
+    {
+        _gustFrequency = gustFrequency;
+    }
+}
+
+void PulseCapture::clearBucket(PulseBucket &bucket)
+{
+    bucket.Count = 0;
+    bucket.FirstEdge = 0;
+    bucket.LastEdge = 0;
+    bucket.ReferenceEdge = 0;
+    bucket.HasReferenceEdge = false;
+}
+
+// pulse frequency in mHz from the periods between the edges of a range
+uint32_t PulseCapture::getFrequency(uint32_t count, uint32_t firstEdge, uint32_t lastEdge, uint32_t referenceEdge, bool hasReferenceEdge)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    if (hasReferenceEdge && firstEdge - referenceEdge <= PULSE_CAPTURE_MAX_PERIOD)
+    {
+        return (uint32_t)((uint64_t)count * 1000000000ULL / (lastEdge - referenceEdge));
+    }
+    if (count >= 2)
+    {
+        return (uint32_t)((uint64_t)(count - 1) * 1000000000ULL / (lastEdge - firstEdge));
+    }
+    return 0;
+}
+
+uint32_t PulseCapture::getInstantFrequency()
+{
+    if (_lastPeriod == 0 || _lastPeriod > PULSE_CAPTURE_MAX_PERIOD)
+    {
+        return 0;
+    }
+    return 1000000000UL / _lastPeriod;
+}
+
+uint32_t PulseCapture::getPeakFrequency()
+{
+    return _peakFrequency;
+}
+
+uint32_t PulseCapture::getGustFrequency()
+{
+    return _gustFrequency;
+}
+
+float PulseCapture::toWindspeed(uint32_t frequency)
+{
+    return _calibrationCurve->getWindspeed(frequency) / 1000.0f;
+}
+
+// windspeed in m/s derived from the last pulse period
+float PulseCapture::getInstantWindspeed()
+{
+    return toWindspeed(getInstantFrequency());
+}
+
+// highest 250ms mean windspeed in m/s since the last resetPeaks
+float PulseCapture::getPeakWindspeed()
+{
+    return toWindspeed(_peakFrequency);
+}
+
+// highest 3s mean windspeed in m/s since the last resetPeaks
+float PulseCapture::getGustWindspeed()
+{
+    return toWindspeed(_gustFrequency);
+}
+
+// accepted edges since the start, glitches are not counted
+uint32_t PulseCapture::getEdgeCount()
+{
+    return _edgeCount;
+}
+
+uint32_t PulseCapture::getGlitchCount()
+{
+    return _glitchCount;
+}
+
+uint32_t PulseCapture::getOverrunCount()
+{
+    return _overrunCount.load(std::memory_order_relaxed);
+}
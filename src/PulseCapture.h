@@ -0,0 +1,82 @@
+#ifndef PulseCapture_h
+#define PulseCapture_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "CalibrationCurve.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#endif
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#define PULSE_CAPTURE_BUFFER_SIZE 1024     // edges, must be a power of two, about 3.5s at 25m/s
+#define PULSE_CAPTURE_MIN_PERIOD 1000      // us, shorter periods are rejected as glitches
+#define PULSE_CAPTURE_MAX_PERIOD 1000000   // us, longer periods are treated as calm
+#define PULSE_CAPTURE_PEAK_RANGE 250000    // us
+#define PULSE_CAPTURE_GUST_BUCKETS 12      // peak ranges per gust range (3s WMO gust)
+
+// accumulated edges of one peak range
+struct PulseBucket
+{
+    uint16_t Count;
+    uint32_t FirstEdge;
+    uint32_t LastEdge;
+    uint32_t ReferenceEdge;
+    bool HasReferenceEdge;
+};
+
+// records the timestamp of every sensor edge from the interrupt into a lock-free
+// single producer/single consumer ring buffer and derives instantaneous, 250ms peak
+// and 3s gust pulse frequencies from the pulse periods and counts on the consumer side
+class PulseCapture
+{
+public:
+    PulseCapture(CalibrationCurve *calibrationCurve, uint32_t minimumPeriod = PULSE_CAPTURE_MIN_PERIOD);
+    void recordEdge(uint32_t timestamp);
+    void process(uint32_t timestamp);
+    void reset();
+    void resetPeaks();
+    float getInstantWindspeed();
+    float getPeakWindspeed();
+    float getGustWindspeed();
+    uint32_t getInstantFrequency();
+    uint32_t getPeakFrequency();
+    uint32_t getGustFrequency();
+    uint32_t getEdgeCount();
+    uint32_t getGlitchCount();
+    uint32_t getOverrunCount();
+
+private:
+    uint32_t _minimumPeriod;
+    CalibrationCurve *_calibrationCurve;
+    uint32_t _buffer[PULSE_CAPTURE_BUFFER_SIZE];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _overrunCount{0};
+    uint32_t _edgeCount = 0;
+    uint32_t _glitchCount = 0;
+    bool _hasLastEdge = false;
+    uint32_t _lastEdge = 0;
+    uint32_t _lastPeriod = 0;
+    bool _hasBucketStart = false;
+    uint32_t _bucketStart = 0;
+    PulseBucket _currentBucket;
+    PulseBucket _buckets[PULSE_CAPTURE_GUST_BUCKETS];
+    uint8_t _bucketIndex = 0;
+    uint8_t _numberOfClosedBuckets = 0;
+    uint32_t _peakFrequency = 0;
+    uint32_t _gustFrequency = 0;
+    void addEdge(uint32_t timestamp);
+    void closeBuckets(uint32_t timestamp);
+    void closeBucket();
+    void clearBucket(PulseBucket &bucket);
+    uint32_t getFrequency(uint32_t count, uint32_t firstEdge, uint32_t lastEdge, uint32_t referenceEdge, bool hasReferenceEdge);
+    float toWindspeed(uint32_t frequency);
+};
+
+#endif
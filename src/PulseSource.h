@@ -0,0 +1,19 @@
+#ifndef PulseSource_h
+#define PulseSource_h
+
+#include <stdint.h>
+#include "PulseCapture.h"
+
+// source of the accumulated anemometer pulse count, polled once per sample
+class PulseSource
+{
+public:
+    virtual ~PulseSource() {}
+    virtual void begin() = 0;
+    virtual uint32_t getCount() = 0;
+    // edge timestamps are only available from sources which see every single edge
+    virtual void setupPulseCapture(PulseCapture *pulseCapture) {}
+    virtual bool hasEdgeTimestamps() { return false; }
+};
+
+#endif
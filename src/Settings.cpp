@@ -0,0 +1,98 @@
+#include "Settings.h"
+
+static const SettingsField *findSettingsField(const char *name)
+{
+    for (size_t i = 0; name != nullptr && i < sizeof(SETTINGS_SCHEMA) / sizeof(SETTINGS_SCHEMA[0]); i++)
+    {
+        if (strcmp(name, SETTINGS_SCHEMA[i].Name) == 0)
+        {
+            return &SETTINGS_SCHEMA[i];
+        }
+    }
+    return nullptr;
+}
+
+// integer numbers or strings of them, the webpage sends the values of its input fields as strings
+static bool parseSettingsValue(JsonVariantConst jsonValue, int &value)
+{
+    if (jsonValue.is<int>())
+    {
+        value = jsonValue.as<int>();
+        return true;
+    }
+    const char *text = jsonValue.as<const char *>();
+    if (text == nullptr || *text == '\0')
+    {
+        return false;
+    }
+    char *end = nullptr;
+    long number = strtol(text, &end, 10);
+    if (*end != '\0' || number < INT16_MIN || number > INT16_MAX)
+    {
+        return false;
+    }
+    value = (int)number;
+    return true;
+}
+
+SettingsPatchResult applySettingsPatch(Settings &settings, JsonVariantConst patch)
+{
+    SettingsPatchResult result = {false, nullptr, nullptr, 0};
+    JsonObjectConst patchObject = patch.as<JsonObjectConst>();
+    if (patchObject.isNull())
+    {
+        result.Error = "Settings have to be a json object";
+        return result;
+    }
+
+    Settings patchedSettings = settings;
+    for (JsonPairConst pair : patchObject)
+    {
+        const SettingsField *field = findSettingsField(pair.key().c_str());
+        if (field == nullptr)
+        {
+            result.Error = "Unknown setting";
+            return result;
+        }
+        int value = 0;
+        if (!parseSettingsValue(pair.value(), value) || value < field->Minimum || value > field->Maximum)
+        {
+            result.Error = "Setting out of range";
+            result.Field = field->Name;
+            return result;
+        }
+        patchedSettings.*(field->Value) = value;
+    }
+
+    for (size_t i = 0; i < sizeof(SETTINGS_SCHEMA) / sizeof(SETTINGS_SCHEMA[0]); i++)
+    {
+        const SettingsField &field = SETTINGS_SCHEMA[i];
+        if (patchedSettings.*(field.Value) != settings.*(field.Value))
+        {
+            result.ChangedSubsystems |= field.Subsystems;
+        }
+    }
+
+    // the thresholds and ranges are only checked against each other if one of them changed
+    if (result.ChangedSubsystems & SETTINGS_SUBSYSTEM_WINDSPEED)
+    {
+        if (patchedSettings.LowerWindspeedThreshold >= patchedSettings.UpperWindspeedThreshold)
+        {
+            result.Error = "Lower threshold has to be below the upper threshold";
+            result.Field = "LowerWindspeedThreshold";
+            result.ChangedSubsystems = 0;
+            return result;
+        }
+        if (patchedSettings.WindspeedDurationRange > patchedSettings.WindspeedEvaluationRange)
+        {
+            result.Error = "Duration range has to fit into the evaluation range";
+            result.Field = "WindspeedDurationRange";
+            result.ChangedSubsystems = 0;
+            return result;
+        }
+    }
+
+    settings = patchedSettings;
+    result.IsValid = true;
+    return result;
+}
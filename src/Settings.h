@@ -0,0 +1,63 @@
+#ifndef Settings_h
+#define Settings_h
+
+#include "Arduino.h"
+#include <ArduinoJson.h>
+#include "WindSpeedConfig.h"
+
+// subsystems which have to be updated after a change of a setting
+#define SETTINGS_SUBSYSTEM_WINDSPEED 0x01
+#define SETTINGS_SUBSYSTEM_DISPLAY 0x02
+#define SETTINGS_SUBSYSTEM_SPEAKER 0x04
+#define SETTINGS_SUBSYSTEM_POWER 0x08
+#define SETTINGS_SUBSYSTEM_ALL 0x0F
+
+#define SETTINGS_MAX_BODY_SIZE 1024 // bytes of a settings patch
+
+// stored as one blob, the settings version of the store has to be increased with every change
+struct Settings
+{
+    int Volume;
+    int CalibrationFactor;
+    int LowerWindspeedThreshold;
+    int UpperWindspeedThreshold;
+    int WindspeedEvaluationRange;
+    int WindspeedDurationRange;
+    int WindspeedNumberOfWindows;
+    int DisplayBrightness;
+    int MaximumChargeCurrent;
+};
+
+// setting which could be changed with a patch of the settings api
+struct SettingsField
+{
+    const char *Name;
+    int Settings::*Value;
+    int Minimum;
+    int Maximum;
+    uint8_t Subsystems;
+};
+
+static const SettingsField SETTINGS_SCHEMA[] = {
+    {"Volume", &Settings::Volume, 0, 100, SETTINGS_SUBSYSTEM_SPEAKER},
+    {"LowerWindspeedThreshold", &Settings::LowerWindspeedThreshold, 0, 5, SETTINGS_SUBSYSTEM_WINDSPEED | SETTINGS_SUBSYSTEM_DISPLAY},
+    {"UpperWindspeedThreshold", &Settings::UpperWindspeedThreshold, 2, 25, SETTINGS_SUBSYSTEM_WINDSPEED | SETTINGS_SUBSYSTEM_DISPLAY},
+    {"WindspeedEvaluationRange", &Settings::WindspeedEvaluationRange, WindSpeedConfig::MIN_DURATION_RANGE, WindSpeedConfig::MAX_EVALUATION_RANGE, SETTINGS_SUBSYSTEM_WINDSPEED | SETTINGS_SUBSYSTEM_DISPLAY},
+    {"WindspeedDurationRange", &Settings::WindspeedDurationRange, WindSpeedConfig::MIN_DURATION_RANGE, 120, SETTINGS_SUBSYSTEM_WINDSPEED | SETTINGS_SUBSYSTEM_DISPLAY},
+    {"WindspeedNumberOfWindows", &Settings::WindspeedNumberOfWindows, 1, 10, SETTINGS_SUBSYSTEM_WINDSPEED},
+    {"DisplayBrightness", &Settings::DisplayBrightness, 0, 100, SETTINGS_SUBSYSTEM_DISPLAY},
+    {"MaximumChargeCurrent", &Settings::MaximumChargeCurrent, 100, 1000, SETTINGS_SUBSYSTEM_POWER},
+};
+
+struct SettingsPatchResult
+{
+    bool IsValid;
+    const char *Error;
+    const char *Field; // name of the invalid setting
+    uint8_t ChangedSubsystems;
+};
+
+// applies all settings of the patch or none of them, missing settings keep their value
+SettingsPatchResult applySettingsPatch(Settings &settings, JsonVariantConst patch);
+
+#endif
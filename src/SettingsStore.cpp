@@ -0,0 +1,172 @@
+#include "SettingsStore.h"
+#include <memory>
+
+SettingsStore::SettingsStore(const char *preferenceNamespace, const char *key, uint16_t version, void *settings, size_t length, uint32_t commitDelay)
+{
+    _preferenceNamespace = preferenceNamespace;
+    _key = key;
+    _version = version;
+    _settings = (uint8_t *)settings;
+    _length = length;
+    _commitDelay = commitDelay;
+}
+
+// false if there is no blob or it has another version, length or checksum, the settings are untouched then
+bool SettingsStore::load()
+{
+    size_t blobLength = sizeof(SettingsBlobHeader) + _length;
+    std::unique_ptr<uint8_t[]> blob(new (std::nothrow) uint8_t[blobLength]);
+    if (!blob)
+    {
+        return false;
+    }
+
+    Preferences preferences;
+    preferences.begin(_preferenceNamespace, true);
+    size_t length = 0;
+    if (preferences.isKey(_key) && preferences.getBytesLength(_key) == blobLength)
+    {
+        length = preferences.getBytes(_key, blob.get(), blobLength);
+    }
+    preferences.end();
+    if (length != blobLength)
+    {
+        return false;
+    }
+
+    SettingsBlobHeader header;
+    memcpy(&header, blob.get(), sizeof(header));
+    const uint8_t *settings = blob.get() + sizeof(header);
+    if (header.Version != _version || header.Length != _length || header.Checksum != getChecksum(settings, _length))
+    {
+        Serial.println("Stored settings are invalid");
+        return false;
+    }
+
+    memcpy(_settings, settings, _length);
+    portENTER_CRITICAL(&_lock);
+    _storedChecksum = header.Checksum;
+    _hasStoredChecksum = true;
+    _isDirty = false;
+    portEXIT_CRITICAL(&_lock);
+    return true;
+}
+
+// called after every change of the settings, could be called from any task
+void SettingsStore::markDirty()
+{
+    uint32_t checksum = getChecksum(_settings, _length);
+    portENTER_CRITICAL(&_lock);
+    if (_isDirty)
+    {
+        _statistics.NumberOfCoalescedChanges++;
+    }
+    else if (_hasStoredChecksum && checksum == _storedChecksum)
+    {
+        _statistics.NumberOfSkippedWrites++;
+        portEXIT_CRITICAL(&_lock);
+        return;
+    }
+    _isDirty = true;
+    _lastChange = millis();
+    portEXIT_CRITICAL(&_lock);
+}
+
+// polled from the loop, the settings are written once no change happened for the commit delay
+void SettingsStore::update()
+{
+    if (_isDirty && millis() - _lastChange >= _commitDelay)
+    {
+        commit();
+    }
+}
+
+// writes pending changes immediately, e.g. before the deep sleep
+bool SettingsStore::commit()
+{
+    if (!_isDirty)
+    {
+        return true;
+    }
+
+    size_t blobLength = sizeof(SettingsBlobHeader) + _length;
+    std::unique_ptr<uint8_t[]> blob(new (std::nothrow) uint8_t[blobLength]);
+    if (!blob)
+    {
+        return false;
+    }
+
+    // changes during the write mark the settings dirty again
+    portENTER_CRITICAL(&_lock);
+    _isDirty = false;
+    portEXIT_CRITICAL(&_lock);
+    SettingsBlobHeader header = {_version, (uint16_t)_length, 0};
+    memcpy(blob.get() + sizeof(header), _settings, _length);
+    header.Checksum = getChecksum(blob.get() + sizeof(header), _length);
+    memcpy(blob.get(), &header, sizeof(header));
+
+    if (_hasStoredChecksum && header.Checksum == _storedChecksum)
+    {
+        portENTER_CRITICAL(&_lock);
+        _statistics.NumberOfSkippedWrites++;
+        portEXIT_CRITICAL(&_lock);
+        return true;
+    }
+
+    Preferences preferences;
+    preferences.begin(_preferenceNamespace, false);
+    size_t length = preferences.putBytes(_key, blob.get(), blobLength);
+    preferences.end();
+
+    portENTER_CRITICAL(&_lock);
+    if (length != blobLength)
+    {
+        _statistics.NumberOfFailedWrites++;
+        _isDirty = true;
+        _lastChange = millis();
+    }
+    else
+    {
+        _statistics.NumberOfWrites++;
+        _storedChecksum = header.Checksum;
+        _hasStoredChecksum = true;
+    }
+    portEXIT_CRITICAL(&_lock);
+
+    if (length != blobLength)
+    {
+        Serial.println("Settings could not be saved");
+        return false;
+    }
+    Serial.println("Settings saved");
+    return true;
+}
+
+bool SettingsStore::isDirty()
+{
+    return _isDirty;
+}
+
+SettingsStoreStatistics SettingsStore::getStatistics()
+{
+    portENTER_CRITICAL(&_lock);
+    SettingsStoreStatistics statistics = _statistics;
+    portEXIT_CRITICAL(&_lock);
+    return statistics;
+}
+
+// crc-32 (ieee 802.3), the settings are too small for a table
+uint32_t SettingsStore::getChecksum(const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
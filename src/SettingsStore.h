@@ -0,0 +1,54 @@
+#ifndef SettingsStore_h
+#define SettingsStore_h
+
+#include "Arduino.h"
+#include <Preferences.h>
+
+#define SETTINGS_STORE_COMMIT_DELAY 2000 // ms, successive changes within this delay are written once
+
+// stored in front of the settings struct
+struct SettingsBlobHeader
+{
+    uint16_t Version;
+    uint16_t Length;
+    uint32_t Checksum;
+};
+
+struct SettingsStoreStatistics
+{
+    uint32_t NumberOfWrites;
+    uint32_t NumberOfSkippedWrites;  // changes which did not change the stored settings
+    uint32_t NumberOfCoalescedChanges; // changes which were written together with a later change
+    uint32_t NumberOfFailedWrites;
+};
+
+// persists a settings struct as one versioned blob with a checksum, changes are marked dirty and
+// written from the loop after the commit delay, unchanged settings are not written at all
+class SettingsStore
+{
+public:
+    SettingsStore(const char *preferenceNamespace, const char *key, uint16_t version, void *settings, size_t length, uint32_t commitDelay = SETTINGS_STORE_COMMIT_DELAY);
+    bool load();
+    void markDirty();
+    void update();
+    bool commit();
+    bool isDirty();
+    SettingsStoreStatistics getStatistics();
+    static uint32_t getChecksum(const void *data, size_t length);
+
+private:
+    const char *_preferenceNamespace;
+    const char *_key;
+    uint16_t _version;
+    uint8_t *_settings;
+    size_t _length;
+    uint32_t _commitDelay;
+    uint32_t _storedChecksum = 0;
+    bool _hasStoredChecksum = false;
+    volatile bool _isDirty = false;
+    volatile uint32_t _lastChange = 0;
+    SettingsStoreStatistics _statistics = {};
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "SimulatedPulseSource.h"
+
+void SimulatedPulseSource::begin()
+{
+    _counter = 0;
+}
+
+uint32_t SimulatedPulseSource::getCount()
+{
+    return _counter;
+}
+
+void SimulatedPulseSource::setupPulseCapture(PulseCapture *pulseCapture)
+{
+    _pulseCapture = pulseCapture;
+}
+
+bool SimulatedPulseSource::hasEdgeTimestamps()
+{
+    return true;
+}
+
+void SimulatedPulseSource::addPulses(uint32_t numberOfPulses)
+{
+    _counter += numberOfPulses;
+}
+
+// edge at timestamp in us, counted and forwarded like an interrupt would do
+void SimulatedPulseSource::addEdge(uint32_t timestamp)
+{
+    _counter++;
+    if (_pulseCapture != nullptr)
+    {
+        _pulseCapture->recordEdge(timestamp);
+    }
+}
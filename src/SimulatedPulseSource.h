@@ -0,0 +1,23 @@
+#ifndef SimulatedPulseSource_h
+#define SimulatedPulseSource_h
+
+#include <stdint.h>
+#include "PulseSource.h"
+
+// pulse source without hardware, pulses and edges are injected by the caller for host tests
+class SimulatedPulseSource : public PulseSource
+{
+public:
+    void begin() override;
+    uint32_t getCount() override;
+    void setupPulseCapture(PulseCapture *pulseCapture) override;
+    bool hasEdgeTimestamps() override;
+    void addPulses(uint32_t numberOfPulses);
+    void addEdge(uint32_t timestamp);
+
+private:
+    uint32_t _counter = 0;
+    PulseCapture *_pulseCapture = nullptr;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SnapshotFile_h
+#define SnapshotFile_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include "WindSpeedConfig.h"
+
+#define SNAPSHOT_FILE_MAGIC 0x31535846 // "FXS1"
+#define SNAPSHOT_FILE_VERSION 1
+#define SNAPSHOT_FILE_EXTENSION ".fxs"
+
+// binary snapshot file: header, NumberOfExceededRanges x SnapshotFileRange and
+// NumberOfSamples x int16_t windspeed in 0.1 m/s, oldest sample first. All values
+// little endian, readers skip to HeaderSize so fields could be appended later.
+struct SnapshotFileHeader
+{
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t HeaderSize;
+    uint32_t Time; // unix time of the newest sample
+    uint16_t SamplePeriod; // ms
+    uint16_t NumberOfSamples;
+    // settings in effect
+    uint16_t LowerWindspeedThreshold; // m/s
+    uint16_t UpperWindspeedThreshold; // m/s
+    uint16_t WindspeedDurationRange;
+    uint16_t NumberOfWindowsThreshold;
+    uint16_t NumberOfExceededRanges;
+    uint16_t Reserved;
+    // evaluation, windspeeds in m/s
+    float CurrentWindspeed;
+    float GustWindspeed;
+    float PeakWindspeed;
+    float MinWindspeed;
+    float MaxWindspeed;
+    float AverageWindspeed;
+    float SmoothedWindspeed;
+    float WindspeedSlope;
+    float TimeToLowerThreshold;
+    float TimeToUpperThreshold;
+};
+
+struct SnapshotFileRange
+{
+    uint16_t StartIndex;
+    uint16_t StopIndex;
+};
+
+static_assert(sizeof(SnapshotFileHeader) == 68, "snapshot file header layout changed");
+static_assert(sizeof(WindSpeedConfig::StorageType) == sizeof(int16_t), "snapshot samples are stored as int16_t");
+
+#endif
@@ -0,0 +1,200 @@
+#include "SnapshotRenderer.h"
+
+SnapshotRenderer::SnapshotRenderer()
+{
+}
+
+bool SnapshotRenderer::open(fs::FS &fs, const char *path, SnapshotFormat format)
+{
+    File file = fs.open(path, FILE_READ);
+    if (!file)
+    {
+        return false;
+    }
+
+    bool isValid = file.read((uint8_t *)&_header, sizeof(_header)) == sizeof(_header)
+        && _header.Magic == SNAPSHOT_FILE_MAGIC
+        && _header.Version == SNAPSHOT_FILE_VERSION
+        && _header.HeaderSize >= sizeof(_header)
+        && _header.NumberOfSamples <= WindSpeedConfig::MAX_EVALUATION_RANGE
+        && _header.NumberOfExceededRanges <= WindSpeedConfig::MAX_NUMBER_OF_RANGES
+        && file.seek(_header.HeaderSize);
+    if (isValid)
+    {
+        size_t rangesLength = _header.NumberOfExceededRanges * sizeof(SnapshotFileRange);
+        size_t samplesLength = _header.NumberOfSamples * sizeof(int16_t);
+        isValid = file.read((uint8_t *)_ranges, rangesLength) == rangesLength
+            && file.read((uint8_t *)_samples, samplesLength) == samplesLength;
+    }
+    file.close();
+    if (!isValid)
+    {
+        Serial.printf("Invalid snapshot file: %s\n", path);
+        return false;
+    }
+
+    _format = format;
+    _lineIndex = 0;
+    _output = nullptr;
+    _outputLength = 0;
+    _outputPosition = 0;
+    if (_format == SnapshotFormat::EVALUATION_JSON)
+    {
+        renderEvaluationJson();
+    }
+    return true;
+}
+
+// copies the next part of the rendered output, 0 at the end
+size_t SnapshotRenderer::read(uint8_t *buffer, size_t maxLength)
+{
+    size_t length = 0;
+    while (length < maxLength)
+    {
+        if (_outputPosition >= _outputLength && !renderNextLine())
+        {
+            break;
+        }
+        size_t partLength = min(maxLength - length, _outputLength - _outputPosition);
+        memcpy(buffer + length, _output + _outputPosition, partLength);
+        _outputPosition += partLength;
+        length += partLength;
+    }
+    return length;
+}
+
+bool SnapshotRenderer::renderNextLine()
+{
+    size_t numberOfSamples = _header.NumberOfSamples;
+    size_t lineLength = 0;
+    _output = _line;
+
+    switch (_format)
+    {
+    case SnapshotFormat::CSV:
+        if (_lineIndex == 0)
+        {
+            lineLength = TextFormatter(_line, sizeof(_line)).append("Timestamp(UTC), Windspeed[m/s]\r\n").length();
+        }
+        else if (_lineIndex <= numberOfSamples)
+        {
+            lineLength = renderSampleLine(_lineIndex - 1);
+        }
+        else
+        {
+            return false;
+        }
+        break;
+
+    case SnapshotFormat::JSON:
+        if (_lineIndex == 0)
+        {
+            lineLength = TextFormatter(_line, sizeof(_line)).append('[').length();
+        }
+        else if (_lineIndex <= numberOfSamples)
+        {
+            lineLength = renderSampleLine(_lineIndex - 1);
+        }
+        else if (_lineIndex == numberOfSamples + 1)
+        {
+            lineLength = TextFormatter(_line, sizeof(_line)).append(']').length();
+        }
+        else
+        {
+            return false;
+        }
+        break;
+
+    case SnapshotFormat::EVALUATION_JSON:
+        if (_lineIndex > 0)
+        {
+            return false;
+        }
+        _output = _evaluationDocument->getJson();
+        lineLength = _evaluationDocument->getLength();
+        break;
+    }
+
+    _outputLength = lineLength;
+    _outputPosition = 0;
+    _lineIndex++;
+    return true;
+}
+
+// windspeeds in 0.1 m/s are written as fixed point numbers
+size_t SnapshotRenderer::renderSampleLine(size_t sampleIndex)
+{
+    TextFormatter formatter(_line, sizeof(_line));
+    if (_format == SnapshotFormat::JSON)
+    {
+        formatter.append(sampleIndex > 0 ? ",{\"x\":" : "{\"x\":").appendUnsigned(sampleIndex);
+        formatter.append(",\"y\":").appendFixed(_samples[sampleIndex], 1, true).append('}');
+        return formatter.length();
+    }
+
+    // consecutive rows advance the clock by the sample period of the snapshot, the last row is the snapshot time
+    _clock.update(_header.Time - (time_t)((uint32_t)(_header.NumberOfSamples - 1 - sampleIndex) * _header.SamplePeriod / 1000));
+    formatter.append(_clock.getTimestamp());
+    formatter.append(',').appendFixed(_samples[sampleIndex], 1).append("\r\n");
+    return formatter.length();
+}
+
+void SnapshotRenderer::renderEvaluationJson()
+{
+    WindspeedEvaluation windspeedEvaluation;
+    windspeedEvaluation.MinWindspeed = _header.MinWindspeed;
+    windspeedEvaluation.MaxWindspeed = _header.MaxWindspeed;
+    windspeedEvaluation.AverageWindspeed = _header.AverageWindspeed;
+    windspeedEvaluation.NumberOfExceededRanges = _header.NumberOfExceededRanges;
+    for (size_t i = 0; i < _header.NumberOfExceededRanges; i++)
+    {
+        windspeedEvaluation.RangeStartIndex[i] = _ranges[i].StartIndex;
+        windspeedEvaluation.RangeStopIndex[i] = _ranges[i].StopIndex;
+    }
+    windspeedEvaluation.SmoothedWindspeed = _header.SmoothedWindspeed;
+    windspeedEvaluation.WindspeedSlope = _header.WindspeedSlope;
+    windspeedEvaluation.TimeToLowerThreshold = _header.TimeToLowerThreshold;
+    windspeedEvaluation.TimeToUpperThreshold = _header.TimeToUpperThreshold;
+
+    // kept in the arena until the renderer of the response is destroyed
+    _evaluationDocument.reset(new JsonArenaDocument(jsonArenaPool));
+    JsonDocument &jsonDocument = _evaluationDocument->getDocument();
+    WindSpeed::addWindspeedEvaluationJson(jsonDocument, windspeedEvaluation, _header.CurrentWindspeed, _header.GustWindspeed, _header.PeakWindspeed);
+    JsonObject settings = jsonDocument["Settings"].to<JsonObject>();
+    settings["LowerWindspeedThreshold"] = _header.LowerWindspeedThreshold;
+    settings["UpperWindspeedThreshold"] = _header.UpperWindspeedThreshold;
+    settings["WindspeedDurationRange"] = _header.WindspeedDurationRange;
+    settings["WindspeedEvaluationRange"] = _header.NumberOfSamples;
+    settings["WindspeedNumberOfWindows"] = _header.NumberOfWindowsThreshold;
+    settings["SamplePeriod"] = _header.SamplePeriod;
+
+    _evaluationDocument->serialize();
+}
+
+// maps the file path of a rendered format to the binary snapshot it is rendered from
+bool SnapshotRenderer::getSnapshotPath(const String &filePath, String &snapshotPath, SnapshotFormat &format)
+{
+    // the evaluation suffix has to be checked before the json suffix
+    static const SnapshotFormat formats[] = {SnapshotFormat::EVALUATION_JSON, SnapshotFormat::JSON, SnapshotFormat::CSV};
+    for (SnapshotFormat candidate : formats)
+    {
+        const char *suffix = SNAPSHOT_FORMAT_SUFFIXES[(uint8_t)candidate];
+        if (filePath.endsWith(suffix))
+        {
+            snapshotPath = filePath.substring(0, filePath.length() - strlen(suffix)) + SNAPSHOT_FILE_EXTENSION;
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+String SnapshotRenderer::getRenderedFilePath(const String &snapshotPath, SnapshotFormat format)
+{
+    return snapshotPath.substring(0, snapshotPath.length() - strlen(SNAPSHOT_FILE_EXTENSION)) + SNAPSHOT_FORMAT_SUFFIXES[(uint8_t)format];
+}
+
+const char *SnapshotRenderer::getContentType(SnapshotFormat format)
+{
+    return format == SnapshotFormat::CSV ? "text/csv" : "application/json";
+}
@@ -0,0 +1,54 @@
+#ifndef SnapshotRenderer_h
+#define SnapshotRenderer_h
+
+#include "Arduino.h"
+#include <FS.h>
+#include <ArduinoJson.h>
+#include "SnapshotFile.h"
+#include "TextFormatter.h"
+#include "Clock.h"
+#include "WindSpeed.h"
+#include "JsonArena.h"
+#include <memory>
+
+enum struct SnapshotFormat
+{
+    CSV = 0,
+    JSON = 1,
+    EVALUATION_JSON = 2
+};
+
+// file name suffixes of the rendered formats, indexed by SnapshotFormat
+static const char *const SNAPSHOT_FORMAT_SUFFIXES[] = {".csv", ".json", "_evaluation.json"};
+
+// renders a binary snapshot file into the former csv and json snapshot formats. The
+// snapshot is read once on open, the output is produced line by line on each read, so
+// it could be used as the source of a chunked response.
+class SnapshotRenderer
+{
+public:
+    SnapshotRenderer();
+    bool open(fs::FS &fs, const char *path, SnapshotFormat format);
+    size_t read(uint8_t *buffer, size_t maxLength);
+    static bool getSnapshotPath(const String &filePath, String &snapshotPath, SnapshotFormat &format);
+    static String getRenderedFilePath(const String &snapshotPath, SnapshotFormat format);
+    static const char *getContentType(SnapshotFormat format);
+
+private:
+    SnapshotFileHeader _header;
+    SnapshotFileRange _ranges[WindSpeedConfig::MAX_NUMBER_OF_RANGES];
+    int16_t _samples[WindSpeedConfig::MAX_EVALUATION_RANGE];
+    SnapshotFormat _format = SnapshotFormat::CSV;
+    std::unique_ptr<JsonArenaDocument> _evaluationDocument;
+    Clock _clock;
+    char _line[64];
+    const char *_output = nullptr;
+    size_t _outputLength = 0;
+    size_t _outputPosition = 0;
+    uint32_t _lineIndex = 0;
+    bool renderNextLine();
+    size_t renderSampleLine(size_t sampleIndex);
+    void renderEvaluationJson();
+};
+
+#endif
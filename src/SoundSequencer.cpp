@@ -0,0 +1,91 @@
+#include "SoundSequencer.h"
+#include <M5Unified.h>
+
+SoundSequencer::SoundSequencer()
+{
+}
+
+// patterns are queued behind the playing one, a full queue drops the pattern
+void SoundSequencer::play(const SoundPattern *pattern)
+{
+    if (pattern == nullptr || pattern->NumberOfTones == 0)
+    {
+        return;
+    }
+    if (_pattern == nullptr)
+    {
+        startPattern(pattern);
+        return;
+    }
+    if (_queueLength >= SOUND_SEQUENCER_QUEUE_SIZE)
+    {
+        Serial.println("Sound queue full");
+        return;
+    }
+    _queue[(_queueHead + _queueLength) % SOUND_SEQUENCER_QUEUE_SIZE] = pattern;
+    _queueLength++;
+}
+
+// stops the playing pattern and clears the queue
+void SoundSequencer::stop()
+{
+    _pattern = nullptr;
+    _queueLength = 0;
+    M5.Speaker.stop();
+}
+
+void SoundSequencer::update()
+{
+    if (_pattern == nullptr)
+    {
+        return;
+    }
+    if (millis() - _toneStart < _pattern->Tones[_toneIndex].Duration)
+    {
+        return;
+    }
+
+    _toneIndex++;
+    if (_toneIndex >= _pattern->NumberOfTones)
+    {
+        _toneIndex = 0;
+        _repeatCount++;
+        if (_pattern->Repeat != SOUND_PATTERN_ENDLESS && _repeatCount >= _pattern->Repeat)
+        {
+            _pattern = nullptr;
+            if (_queueLength > 0)
+            {
+                const SoundPattern *pattern = _queue[_queueHead];
+                _queueHead = (_queueHead + 1) % SOUND_SEQUENCER_QUEUE_SIZE;
+                _queueLength--;
+                startPattern(pattern);
+            }
+            return;
+        }
+    }
+    startTone();
+}
+
+bool SoundSequencer::isPlaying()
+{
+    return _pattern != nullptr;
+}
+
+void SoundSequencer::startPattern(const SoundPattern *pattern)
+{
+    _pattern = pattern;
+    _toneIndex = 0;
+    _repeatCount = 0;
+    startTone();
+}
+
+// the speaker plays the tone in its own task, so this returns immediately
+void SoundSequencer::startTone()
+{
+    const SoundTone &tone = _pattern->Tones[_toneIndex];
+    _toneStart = millis();
+    if (tone.Frequency > 0.0f)
+    {
+        M5.Speaker.tone(tone.Frequency, tone.Duration);
+    }
+}
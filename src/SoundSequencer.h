@@ -0,0 +1,47 @@
+#ifndef SoundSequencer_h
+#define SoundSequencer_h
+
+#include "Arduino.h"
+
+#define SOUND_SEQUENCER_QUEUE_SIZE 4
+#define SOUND_PATTERN_ENDLESS 0
+
+// a tone with a frequency of 0 is a pause
+struct SoundTone
+{
+    float Frequency; // Hz
+    uint16_t Duration; // ms
+};
+
+// the tones are played in sequence, the whole sequence is repeated Repeat times
+struct SoundPattern
+{
+    const SoundTone *Tones;
+    uint8_t NumberOfTones;
+    uint8_t Repeat;
+};
+
+// plays queued tone patterns on the speaker without blocking, update has to be called
+// from the loop and advances to the next tone when the current one is finished
+class SoundSequencer
+{
+public:
+    SoundSequencer();
+    void play(const SoundPattern *pattern);
+    void stop();
+    void update();
+    bool isPlaying();
+
+private:
+    const SoundPattern *_queue[SOUND_SEQUENCER_QUEUE_SIZE];
+    uint8_t _queueHead = 0;
+    uint8_t _queueLength = 0;
+    const SoundPattern *_pattern = nullptr;
+    uint8_t _toneIndex = 0;
+    uint8_t _repeatCount = 0;
+    uint32_t _toneStart = 0;
+    void startPattern(const SoundPattern *pattern);
+    void startTone();
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "SpiBus.h"
+
+SpiBus::SpiBus()
+{
+    for (size_t i = 0; i < SPI_BUS_NUMBER_OF_PRIORITIES; i++)
+    {
+        _numberOfWaitingClients[i].store(0);
+    }
+}
+
+void SpiBus::setup()
+{
+    _mutex = xSemaphoreCreateMutex();
+    if (_mutex == nullptr)
+    {
+        Serial.println("Failed to create spi bus mutex");
+    }
+}
+
+// timeout in ms, returns false if the bus was not granted in time
+bool SpiBus::acquire(SpiBusPriority priority, uint32_t timeout)
+{
+    TRACE_SPAN("spi_bus_acquire");
+    if (_mutex == nullptr)
+    {
+        return true;
+    }
+    uint8_t index = (uint8_t)priority;
+    uint32_t start = millis();
+    bool isAcquired = false;
+    _numberOfWaitingClients[index]++;
+    while (true)
+    {
+        if (isHigherPriorityWaiting(index))
+        {
+            vTaskDelay(pdMS_TO_TICKS(SPI_BUS_POLL_INTERVAL));
+        }
+        else if (xSemaphoreTake(_mutex, timeout > 0 ? pdMS_TO_TICKS(SPI_BUS_POLL_INTERVAL) : 0) == pdTRUE)
+        {
+            isAcquired = true;
+            break;
+        }
+        if (millis() - start >= timeout)
+        {
+            break;
+        }
+    }
+    _numberOfWaitingClients[index]--;
+
+    uint32_t waitTime = millis() - start;
+    SpiBusStatistics &statistics = _statistics[index];
+    if (isAcquired)
+    {
+        statistics.NumberOfGrants++;
+    }
+    else
+    {
+        statistics.NumberOfTimeouts++;
+    }
+    if (waitTime > statistics.MaxWaitTime)
+    {
+        statistics.MaxWaitTime = waitTime;
+    }
+    return isAcquired;
+}
+
+void SpiBus::release()
+{
+    if (_mutex != nullptr)
+    {
+        xSemaphoreGive(_mutex);
+    }
+}
+
+SpiBusStatistics SpiBus::getStatistics(SpiBusPriority priority)
+{
+    return _statistics[(uint8_t)priority];
+}
+
+bool SpiBus::isHigherPriorityWaiting(uint8_t priority)
+{
+    for (uint8_t i = 0; i < priority; i++)
+    {
+        if (_numberOfWaitingClients[i].load() > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+SpiBusLock::SpiBusLock(SpiBus *spiBus, SpiBusPriority priority, uint32_t timeout)
+{
+    _spiBus = spiBus;
+    _isAcquired = _spiBus == nullptr || _spiBus->acquire(priority, timeout);
+}
+
+SpiBusLock::~SpiBusLock()
+{
+    if (_spiBus != nullptr && _isAcquired)
+    {
+        _spiBus->release();
+    }
+}
+
+bool SpiBusLock::isAcquired()
+{
+    return _isAcquired;
+}
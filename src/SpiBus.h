@@ -0,0 +1,61 @@
+#ifndef SpiBus_h
+#define SpiBus_h
+
+#include "Arduino.h"
+#include <atomic>
+#include "Tracer.h"
+
+#define SPI_BUS_NUMBER_OF_PRIORITIES 3
+#define SPI_BUS_POLL_INTERVAL 1 // ms, lower priorities wait while a higher priority is waiting
+#define SPI_BUS_LOGGING_TIMEOUT 1000 // ms
+#define SPI_BUS_DISPLAY_TIMEOUT 50   // ms, the display is drawn again with the next sample
+
+// sd card and display share the spi bus, lower values are granted first
+enum struct SpiBusPriority
+{
+    LOGGING = 0,
+    DISPLAY = 1,
+    DOWNLOAD = 2
+};
+
+static const char *const SPI_BUS_PRIORITY_NAMES[] = {"Logging", "Display", "Download"};
+
+struct SpiBusStatistics
+{
+    uint32_t NumberOfGrants;
+    uint32_t NumberOfTimeouts;
+    uint32_t MaxWaitTime; // ms
+};
+
+// grants the shared spi bus to one task at a time, a waiting client holds back all clients
+// with a lower priority, so the bus has to be released after every time slice (e.g. one chunk)
+class SpiBus
+{
+public:
+    SpiBus();
+    void setup();
+    bool acquire(SpiBusPriority priority, uint32_t timeout);
+    void release();
+    SpiBusStatistics getStatistics(SpiBusPriority priority);
+
+private:
+    SemaphoreHandle_t _mutex = nullptr;
+    std::atomic<uint8_t> _numberOfWaitingClients[SPI_BUS_NUMBER_OF_PRIORITIES];
+    SpiBusStatistics _statistics[SPI_BUS_NUMBER_OF_PRIORITIES] = {};
+    bool isHigherPriorityWaiting(uint8_t priority);
+};
+
+// acquires the bus for the lifetime of the lock, without bus every lock is granted
+class SpiBusLock
+{
+public:
+    SpiBusLock(SpiBus *spiBus, SpiBusPriority priority, uint32_t timeout);
+    ~SpiBusLock();
+    bool isAcquired();
+
+private:
+    SpiBus *_spiBus;
+    bool _isAcquired;
+};
+
+#endif
@@ -54,7 +54,8 @@ void StartupDisplay::draw()
 
     _display.setFont(&fonts::DejaVu12);
     _display.drawString("Date: " + getTimestampString(), buttonSpacing, 50);
-    _display.drawString("Battery Level: " + String(M5.Power.getBatteryLevel()) + " %", buttonSpacing, 68);
+    TelemetryData telemetryData = _telemetry != nullptr ? _telemetry->getData() : TelemetryData();
+    _display.drawString("Battery Level: " + String(telemetryData.BatteryLevel) + " %", buttonSpacing, 68);
 
     if (_isWifiEnabled)
     {
@@ -158,3 +159,8 @@ void StartupDisplay::setupStartButtonCallback(std::function<void(bool, bool)> st
 {
     _startButtonCallback = startButtonCallback;
 }
+
+void StartupDisplay::setupTelemetry(Telemetry *telemetry)
+{
+    _telemetry = telemetry;
+}
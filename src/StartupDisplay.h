@@ -5,6 +5,7 @@
 #include <M5GFX.h>
 #include <M5Unified.h>
 #include <TimeLib.h>
+#include "Telemetry.h"
 
 #define TXT_DEFAULT_COLOR TFT_WHITE
 #define DEFAULT_BACKGROUND_COLOR TFT_BLACK
@@ -16,6 +17,7 @@ public:
     StartupDisplay();
     void setup(int displayBrightness, bool isAPEnabled = true);
     void setupStartButtonCallback(std::function<void(bool, bool)> startButtonCallback);
+    void setupTelemetry(Telemetry *telemetry);
     void draw();
     void evaluateTouches();
 
@@ -26,6 +28,7 @@ private:
     bool _isAPEnabled = true;
     bool _isStartButtonPressed = false;
     std::function<void(bool, bool)> _startButtonCallback = nullptr;
+    Telemetry *_telemetry = nullptr;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "Telemetry.h"
+
+Telemetry::Telemetry(uint32_t interval)
+{
+    _interval = interval;
+}
+
+// has to be called from one task only, the first call polls immediately
+void Telemetry::update()
+{
+    uint32_t currentMillis = millis();
+    if (_data.getCount() > 0 && currentMillis - _lastUpdate < _interval)
+    {
+        return;
+    }
+    _lastUpdate = currentMillis;
+    poll();
+}
+
+void Telemetry::setInterval(uint32_t interval)
+{
+    _interval = interval;
+}
+
+TelemetryData Telemetry::getData() const
+{
+    return _data.read();
+}
+
+void Telemetry::poll()
+{
+    TelemetryData data;
+    data.BatteryLevel = M5.Power.getBatteryLevel();
+    data.BatteryVoltage = M5.Power.getBatteryVoltage();
+    data.BatteryCurrent = M5.Power.getBatteryCurrent();
+    data.IsCharging = M5.Power.isCharging();
+    data.IsPowerConnected = M5.Power.Axp192.isACIN();
+    data.WifiRSSI = WiFi.RSSI();
+    data.Time = millis();
+    _data.publish(data);
+}
@@ -0,0 +1,39 @@
+#ifndef Telemetry_h
+#define Telemetry_h
+
+#include "Arduino.h"
+#include <M5Unified.h>
+#include <WiFi.h>
+#include "Published.h"
+
+#define TELEMETRY_DEFAULT_INTERVAL 2000 // ms
+
+struct TelemetryData
+{
+    int32_t BatteryLevel;   // %
+    int16_t BatteryVoltage; // mV
+    int32_t BatteryCurrent; // mA
+    bool IsCharging;
+    bool IsPowerConnected;
+    int8_t WifiRSSI; // dB
+    uint32_t Time;   // ms
+};
+
+// polls the power management and wifi values at a fixed interval, so the i2c traffic does not
+// depend on the number of consumers, all consumers read the last published values
+class Telemetry
+{
+public:
+    Telemetry(uint32_t interval = TELEMETRY_DEFAULT_INTERVAL);
+    void update();
+    void setInterval(uint32_t interval);
+    TelemetryData getData() const;
+
+private:
+    uint32_t _interval;
+    uint32_t _lastUpdate = 0;
+    Published<TelemetryData> _data;
+    void poll();
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "TextFormatter.h"
+
+TextFormatter::TextFormatter(char *buffer, size_t size)
+{
+    _buffer = buffer;
+    _size = size;
+    clear();
+}
+
+TextFormatter &TextFormatter::clear()
+{
+    _length = 0;
+    _isTruncated = false;
+    if (_size > 0)
+    {
+        _buffer[0] = '\0';
+    }
+    return *this;
+}
+
+TextFormatter &TextFormatter::append(const char *text)
+{
+    while (*text != '\0')
+    {
+        append(*text++);
+    }
+    return *this;
+}
+
+TextFormatter &TextFormatter::append(char character)
+{
+    if (_length + 1 >= _size)
+    {
+        _isTruncated = true;
+        return *this;
+    }
+    _buffer[_length++] = character;
+    _buffer[_length] = '\0';
+    return *this;
+}
+
+// decimal digits, left padded with zeros to minimumDigits
+TextFormatter &TextFormatter::appendUnsigned(uint32_t value, uint8_t minimumDigits)
+{
+    char digits[10];
+    uint8_t numberOfDigits = 0;
+    do
+    {
+        digits[numberOfDigits++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    for (uint8_t i = numberOfDigits; i < minimumDigits; i++)
+    {
+        append('0');
+    }
+    while (numberOfDigits > 0)
+    {
+        append(digits[--numberOfDigits]);
+    }
+    return *this;
+}
+
+TextFormatter &TextFormatter::appendInteger(int32_t value)
+{
+    if (value < 0)
+    {
+        append('-');
+        return appendUnsigned(0U - (uint32_t)value);
+    }
+    return appendUnsigned(value);
+}
+
+// value in units of 10^-decimals, e.g. 123 with one decimal is 12.3
+TextFormatter &TextFormatter::appendFixed(int32_t value, uint8_t decimals, bool trimZeroFraction)
+{
+    uint32_t magnitude = value < 0 ? 0U - (uint32_t)value : value;
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++)
+    {
+        scale *= 10;
+    }
+    uint32_t fraction = magnitude % scale;
+
+    if (value < 0)
+    {
+        append('-');
+    }
+    appendUnsigned(magnitude / scale);
+    if (decimals > 0 && !(trimZeroFraction && fraction == 0))
+    {
+        append('.');
+        appendUnsigned(fraction, decimals);
+    }
+    return *this;
+}
+
+// YYYY-MM-DD hh:mm:ss with configurable separators
+TextFormatter &TextFormatter::appendDateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second, char dateTimeSeparator, char timeSeparator)
+{
+    appendUnsigned(year, 4).append('-').appendUnsigned(month, 2).append('-').appendUnsigned(day, 2);
+    append(dateTimeSeparator);
+    return appendUnsigned(hour, 2).append(timeSeparator).appendUnsigned(minute, 2).append(timeSeparator).appendUnsigned(second, 2);
+}
+
+const char *TextFormatter::c_str() const
+{
+    return _buffer;
+}
+
+size_t TextFormatter::length() const
+{
+    return _length;
+}
+
+bool TextFormatter::isTruncated() const
+{
+    return _isTruncated;
+}
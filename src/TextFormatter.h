@@ -0,0 +1,32 @@
+#ifndef TextFormatter_h
+#define TextFormatter_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// appends text and integer/fixed point numbers to a caller owned buffer without heap
+// allocations or floating point formatting. The text is always null terminated, output
+// which does not fit into the buffer is cut off and flagged as truncated.
+class TextFormatter
+{
+public:
+    TextFormatter(char *buffer, size_t size);
+    TextFormatter &clear();
+    TextFormatter &append(const char *text);
+    TextFormatter &append(char character);
+    TextFormatter &appendUnsigned(uint32_t value, uint8_t minimumDigits = 1);
+    TextFormatter &appendInteger(int32_t value);
+    TextFormatter &appendFixed(int32_t value, uint8_t decimals, bool trimZeroFraction = false);
+    TextFormatter &appendDateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second, char dateTimeSeparator = ' ', char timeSeparator = ':');
+    const char *c_str() const;
+    size_t length() const;
+    bool isTruncated() const;
+
+private:
+    char *_buffer;
+    size_t _size;
+    size_t _length = 0;
+    bool _isTruncated = false;
+};
+
+#endif
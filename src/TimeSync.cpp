@@ -0,0 +1,148 @@
+#include "TimeSync.h"
+
+TimeSync *TimeSync::_instance = nullptr;
+
+TimeSync::TimeSync()
+{
+}
+
+// sets the system time from the rtc, the only rtc read during runtime
+bool TimeSync::setupRtc()
+{
+    if (!M5.Rtc.isEnabled())
+    {
+        Serial.println("RTC not found.");
+        return false;
+    }
+    Serial.println("RTC found.");
+
+    auto dateTime = M5.Rtc.getDateTime();
+    struct tm t = {};
+    t.tm_year = dateTime.date.year - 1900; // tm_year is years since 1900
+    t.tm_mon = dateTime.date.month - 1;    // tm_mon is 0-based (0 = January)
+    t.tm_mday = dateTime.date.date;
+    t.tm_hour = dateTime.time.hours;
+    t.tm_min = dateTime.time.minutes;
+    t.tm_sec = dateTime.time.seconds;
+    t.tm_isdst = -1;
+
+    struct timeval systemTime = {mktime(&t), 0};
+    settimeofday(&systemTime, nullptr);
+    Serial.println("time synched from RTC");
+    return true;
+}
+
+// sync interval in s, the requests are sent and received by the network task
+void TimeSync::begin(const char *serverName, uint32_t syncInterval)
+{
+    _instance = this;
+    if (sntp_enabled())
+    {
+        sntp_stop();
+    }
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    sntp_setservername(0, serverName);
+    sntp_set_sync_mode(SNTP_SYNC_MODE_SMOOTH);
+    sntp_set_sync_interval(syncInterval * 1000);
+    sntp_set_time_sync_notification_cb(syncCallback);
+    sntp_init();
+    Serial.printf("SNTP started with %s\n", serverName);
+}
+
+// called from the loop, the rtc is written here to keep the i2c bus out of the network task
+void TimeSync::update()
+{
+    updateSystemClockOffset();
+    if (!_isRtcUpdatePending)
+    {
+        return;
+    }
+    _isRtcUpdatePending = false;
+    if (M5.Rtc.isEnabled())
+    {
+        TRACE_SPAN("rtc_update");
+        time_t t = time(nullptr);
+        struct tm dateTime;
+        gmtime_r(&t, &dateTime);
+        M5.Rtc.setDateTime(&dateTime);
+    }
+}
+
+TimeSyncStatus TimeSync::getStatus()
+{
+    TimeSyncStatus status = _status;
+    status.IsSlewing = sntp_get_sync_status() == SNTP_SYNC_STATUS_IN_PROGRESS;
+    return status;
+}
+
+time_t TimeSync::getSystemTime()
+{
+    return time(nullptr);
+}
+
+void TimeSync::syncCallback(struct timeval *serverTime)
+{
+    if (_instance != nullptr)
+    {
+        _instance->handleSync(serverTime);
+    }
+}
+
+// in smooth mode the SNTP client already started slewing by the remaining adjtime delta,
+// or stepped the clock if the offset was too large for adjtime
+void TimeSync::handleSync(struct timeval *serverTime)
+{
+    TRACE_SPAN("time_sync");
+    struct timeval remainingDelta = {0, 0};
+    adjtime(nullptr, &remainingDelta);
+    int64_t offset = (int64_t)remainingDelta.tv_sec * 1000 + remainingDelta.tv_usec / 1000;
+
+    bool isStepped = sntp_get_sync_status() == SNTP_SYNC_STATUS_COMPLETED;
+    if (isStepped)
+    {
+        offset = getSteppedOffset(serverTime);
+    }
+    else if (offset > TIME_SYNC_STEP_THRESHOLD || offset < -TIME_SYNC_STEP_THRESHOLD)
+    {
+        struct timeval noDelta = {0, 0};
+        adjtime(&noDelta, nullptr);
+        settimeofday(serverTime, nullptr);
+        sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+        isStepped = true;
+    }
+
+    _status.IsSynchronized = true;
+    _status.NumberOfSyncs++;
+    _status.NumberOfSteps += isStepped ? 1 : 0;
+    _status.LastOffset = constrain(offset, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+    _status.LastSyncTime = serverTime->tv_sec;
+    _isRtcUpdatePending = true;
+}
+
+// the system time runs with the esp timer except for steps and slewing, so the offset between both
+// taken from the loop gives the system time before the sntp client stepped the clock
+void TimeSync::updateSystemClockOffset()
+{
+    struct timeval systemTime;
+    gettimeofday(&systemTime, nullptr);
+    int64_t systemClockOffset = (int64_t)systemTime.tv_sec * 1000000 + systemTime.tv_usec - esp_timer_get_time();
+    portENTER_CRITICAL(&_lock);
+    _systemClockOffset = systemClockOffset;
+    _hasSystemClockOffset = true;
+    portEXIT_CRITICAL(&_lock);
+}
+
+// ms, server time minus the system time before the step
+int64_t TimeSync::getSteppedOffset(struct timeval *serverTime)
+{
+    portENTER_CRITICAL(&_lock);
+    int64_t systemClockOffset = _systemClockOffset;
+    bool hasSystemClockOffset = _hasSystemClockOffset;
+    portEXIT_CRITICAL(&_lock);
+    if (!hasSystemClockOffset)
+    {
+        return 0;
+    }
+    int64_t systemTime = esp_timer_get_time() + systemClockOffset;
+    return ((int64_t)serverTime->tv_sec * 1000000 + serverTime->tv_usec - systemTime) / 1000;
+}
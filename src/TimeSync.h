@@ -0,0 +1,50 @@
+#ifndef TimeSync_h
+#define TimeSync_h
+
+#include "Arduino.h"
+#include <M5Unified.h>
+#include <esp_sntp.h>
+#include <sys/time.h>
+#include <esp_timer.h>
+#include "Tracer.h"
+
+#define TIME_SYNC_STEP_THRESHOLD 2000 // ms, larger offsets are stepped, smaller ones are slewed
+
+struct TimeSyncStatus
+{
+    bool IsSynchronized;
+    bool IsSlewing;
+    uint32_t NumberOfSyncs;
+    uint32_t NumberOfSteps;
+    int32_t LastOffset; // ms, server time minus system time
+    time_t LastSyncTime;
+};
+
+// keeps the system time in sync without blocking the caller. The time is set once
+// from the rtc, afterwards the lwIP SNTP client of the network task polls the server.
+// Small offsets are slewed with adjtime, only large offsets step the clock. TimeLib
+// reads the system time through getSystemTime, which never waits for the network.
+class TimeSync
+{
+public:
+    TimeSync();
+    bool setupRtc();
+    void begin(const char *serverName, uint32_t syncInterval);
+    void update();
+    TimeSyncStatus getStatus();
+    static time_t getSystemTime();
+
+private:
+    static TimeSync *_instance;
+    volatile bool _isRtcUpdatePending = false;
+    TimeSyncStatus _status = {};
+    int64_t _systemClockOffset = 0; // us, system time minus esp timer
+    bool _hasSystemClockOffset = false;
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+    static void syncCallback(struct timeval *serverTime);
+    void handleSync(struct timeval *serverTime);
+    void updateSystemClockOffset();
+    int64_t getSteppedOffset(struct timeval *serverTime);
+};
+
+#endif
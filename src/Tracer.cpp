@@ -0,0 +1,103 @@
+#include "Tracer.h"
+
+#if TRACER_ENABLED
+
+Tracer tracer;
+
+Tracer::Tracer()
+{
+    static_assert((TRACER_BUFFER_SIZE & (TRACER_BUFFER_SIZE - 1)) == 0, "TRACER_BUFFER_SIZE must be a power of two");
+}
+
+void Tracer::begin(const char *name)
+{
+    record(name, 'B');
+}
+
+void Tracer::end(const char *name)
+{
+    record(name, 'E');
+}
+
+void Tracer::instant(const char *name)
+{
+    record(name, 'i');
+}
+
+// oldest event first, events written while they are copied could be incomplete
+uint32_t Tracer::copyEvents(TraceEvent *events, uint32_t maxNumberOfEvents)
+{
+    uint32_t head = _head.load(std::memory_order_acquire);
+    uint32_t numberOfEvents = min(min(head, (uint32_t)TRACER_BUFFER_SIZE), maxNumberOfEvents);
+    for (uint32_t i = 0; i < numberOfEvents; i++)
+    {
+        events[i] = _events[(head - numberOfEvents + i) & (TRACER_BUFFER_SIZE - 1)];
+    }
+    return numberOfEvents;
+}
+
+void Tracer::record(const char *name, char phase)
+{
+    uint32_t index = _head.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent &event = _events[index & (TRACER_BUFFER_SIZE - 1)];
+    event.Name = name;
+    event.Timestamp = micros();
+    event.TaskId = (uint32_t)xTaskGetCurrentTaskHandle();
+    event.Phase = phase;
+}
+
+TraceExport::TraceExport(Tracer &tracer)
+{
+    _events.reset(new (std::nothrow) TraceEvent[TRACER_BUFFER_SIZE]);
+    if (_events)
+    {
+        _numberOfEvents = tracer.copyEvents(_events.get(), TRACER_BUFFER_SIZE);
+    }
+}
+
+size_t TraceExport::read(uint8_t *buffer, size_t maxLength)
+{
+    size_t length = 0;
+    while (length < maxLength)
+    {
+        if (_linePosition >= _lineLength && !renderNextLine())
+        {
+            break;
+        }
+        size_t partLength = min(maxLength - length, _lineLength - _linePosition);
+        memcpy(buffer + length, _line + _linePosition, partLength);
+        _linePosition += partLength;
+        length += partLength;
+    }
+    return length;
+}
+
+bool TraceExport::renderNextLine()
+{
+    TextFormatter formatter(_line, sizeof(_line));
+    if (_lineIndex == 0)
+    {
+        formatter.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    }
+    else if (_lineIndex <= _numberOfEvents)
+    {
+        const TraceEvent &event = _events[_lineIndex - 1];
+        formatter.append(_lineIndex > 1 ? ",{\"name\":\"" : "{\"name\":\"").append(event.Name != nullptr ? event.Name : "");
+        formatter.append("\",\"ph\":\"").append(event.Phase == 'E' || event.Phase == 'i' ? event.Phase : 'B').append("\",\"ts\":").appendUnsigned(event.Timestamp);
+        formatter.append(",\"pid\":1,\"tid\":").appendUnsigned(event.TaskId).append("}\n");
+    }
+    else if (_lineIndex == _numberOfEvents + 1)
+    {
+        formatter.append("]}\n");
+    }
+    else
+    {
+        return false;
+    }
+    _lineIndex++;
+    _lineLength = formatter.length();
+    _linePosition = 0;
+    return true;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef Tracer_h
+#define Tracer_h
+
+#include "Arduino.h"
+#include <atomic>
+#include <memory>
+#include "TextFormatter.h"
+
+// trace spans could be disabled with a build flag, the spans are compiled out then
+#ifndef TRACER_ENABLED
+#define TRACER_ENABLED 1
+#endif
+#ifndef TRACER_BUFFER_SIZE
+#define TRACER_BUFFER_SIZE 512 // events, must be a power of two
+#endif
+#define TRACE_EXPORT_LINE_SIZE 112
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// without the tracer neither the ring nor the export is compiled
+#if TRACER_ENABLED
+// begin or end of a span, the name has to be a string literal
+struct TraceEvent
+{
+    const char *Name;
+    uint32_t Timestamp; // us
+    uint32_t TaskId;
+    char Phase; // 'B', 'E' or 'i' for an instant event
+};
+
+// ring of the last begin/end and instant events of all tasks, old events are overwritten
+class Tracer
+{
+public:
+    Tracer();
+    void begin(const char *name);
+    void end(const char *name);
+    void instant(const char *name);
+    uint32_t copyEvents(TraceEvent *events, uint32_t maxNumberOfEvents);
+
+private:
+    TraceEvent _events[TRACER_BUFFER_SIZE];
+    std::atomic<uint32_t> _head{0};
+    void record(const char *name, char phase);
+};
+
+// records a span for its lifetime
+class TraceSpan
+{
+public:
+    TraceSpan(Tracer &tracer, const char *name) : _tracer(tracer), _name(name)
+    {
+        _tracer.begin(_name);
+    }
+    ~TraceSpan()
+    {
+        _tracer.end(_name);
+    }
+
+private:
+    Tracer &_tracer;
+    const char *_name;
+};
+
+// copies the ring on creation and renders it line by line as chrome trace event json,
+// so it could be used as the source of a chunked response
+class TraceExport
+{
+public:
+    TraceExport(Tracer &tracer);
+    size_t read(uint8_t *buffer, size_t maxLength);
+
+private:
+    std::unique_ptr<TraceEvent[]> _events;
+    uint32_t _numberOfEvents = 0;
+    char _line[TRACE_EXPORT_LINE_SIZE];
+    size_t _lineLength = 0;
+    size_t _linePosition = 0;
+    uint32_t _lineIndex = 0;
+    bool renderNextLine();
+};
+
+extern Tracer tracer;
+
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(tracer, name)
+#define TRACE_INSTANT(name) tracer.instant(name)
+#else
+#define TRACE_SPAN(name)
+#define TRACE_INSTANT(name)
+#endif
+
+#endif
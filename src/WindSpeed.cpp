@@ -1,34 +1,227 @@
 #include "WindSpeed.h"
 
-WindSpeed::WindSpeed(uint8_t sensorPin, uint16_t windspeedLowerThreshold, uint16_t windspeedUpperThreshold, uint16_t windspeedDurationRange, uint16_t evaluationRange, uint16_t numberOfWindowsThreshold, uint16_t calibrationFactor)
+WindSpeed::WindSpeed(uint8_t sensorPin, uint16_t windspeedLowerThreshold, uint16_t windspeedUpperThreshold, uint16_t windspeedDurationRange, uint16_t evaluationRange, uint16_t numberOfWindowsThreshold, uint16_t calibrationFactor) : _interruptPulseSource(sensorPin), _pulseCapture(&_calibrationCurve)
 {
+    _alarmRules.setupActionCallback([this](uint8_t ruleIndex, const AlarmRule &rule)
+                                    { handleAlarmAction(ruleIndex, rule); });
+    _clock.setupDayChangeCallback([this](const ClockDateTime &dateTime)
+                                  { closeLogFile(); });
     _sensorPin = sensorPin;
-    pinMode(_sensorPin, INPUT_PULLUP);
     _evaluationRange = evaluationRange;
     _windspeedLowerThreshold = windspeedLowerThreshold;
     _windspeedUpperThreshold = windspeedUpperThreshold;
     _windspeedDurationRange = windspeedDurationRange;
     _numberOfWindowsThreshold = numberOfWindowsThreshold;
     _calibrationFactor = calibrationFactor;
+    _calibrationCurve.setCalibrationFactor(_calibrationFactor);
+    applyLimits();
+    rebuildHistogram();
 }
 
 void WindSpeed::setup()
 {
     setupSDCard();
+    setupSnapshotTask();
+}
+
+// snapshots are written by a background task from a pool of preallocated records, so the
+// alarm path only copies the history and sampling continues while the sd card is written
+void WindSpeed::setupSnapshotTask()
+{
+    _freeSnapshotQueue = xQueueCreate(SNAPSHOT_POOL_SIZE, sizeof(WindspeedSnapshot *));
+    _pendingSnapshotQueue = xQueueCreate(SNAPSHOT_POOL_SIZE, sizeof(WindspeedSnapshot *));
+    if (_freeSnapshotQueue == nullptr || _pendingSnapshotQueue == nullptr)
+    {
+        Serial.println("Snapshot queue creation failed");
+        return;
+    }
+    for (size_t i = 0; i < SNAPSHOT_POOL_SIZE; i++)
+    {
+        WindspeedSnapshot *snapshot = &_snapshotPool[i];
+        xQueueSend(_freeSnapshotQueue, &snapshot, 0);
+    }
+    if (xTaskCreate(snapshotTask, "snapshot", SNAPSHOT_TASK_STACK_SIZE, this, SNAPSHOT_TASK_PRIORITY, nullptr) != pdPASS)
+    {
+        Serial.println("Snapshot task creation failed");
+    }
+}
+
+void WindSpeed::snapshotTask(void *parameter)
+{
+    WindSpeed *windSpeed = (WindSpeed *)parameter;
+    WindspeedSnapshot *snapshot;
+    while (true)
+    {
+        if (xQueueReceive(windSpeed->_pendingSnapshotQueue, &snapshot, portMAX_DELAY) == pdTRUE)
+        {
+            SpiBusLock lock(windSpeed->_spiBus, SpiBusPriority::LOGGING, SPI_BUS_LOGGING_TIMEOUT);
+            if (lock.isAcquired())
+            {
+                windSpeed->storeSnapshot(*snapshot);
+            }
+            else
+            {
+                windSpeed->_droppedSnapshotCount++;
+                Serial.println("Snapshot dropped, spi bus busy");
+            }
+            xQueueSend(windSpeed->_freeSnapshotQueue, &snapshot, 0);
+        }
+    }
+}
+
+// called in the sampling path, never waits for a free record
+void WindSpeed::queueSnapshot()
+{
+    WindspeedSnapshot *snapshot;
+    if (_freeSnapshotQueue == nullptr || xQueueReceive(_freeSnapshotQueue, &snapshot, 0) != pdTRUE)
+    {
+        _droppedSnapshotCount++;
+        Serial.println("Snapshot dropped");
+        return;
+    }
+    fillSnapshot(*snapshot);
+    xQueueSend(_pendingSnapshotQueue, &snapshot, 0);
+}
+
+void WindSpeed::fillSnapshot(WindspeedSnapshot &snapshot)
+{
+    snapshot.Time = _clock.getTime();
+    snapshot.EvaluationRange = _evaluationRange;
+    snapshot.SampleRate = _sampleRate;
+    snapshot.LowerWindspeedThreshold = _windspeedLowerThreshold;
+    snapshot.UpperWindspeedThreshold = _windspeedUpperThreshold;
+    snapshot.WindspeedDurationRange = _windspeedDurationRange;
+    snapshot.NumberOfWindowsThreshold = _numberOfWindowsThreshold;
+    snapshot.CurrentWindspeed = getCurrentWindspeed();
+    snapshot.GustWindspeed = _gustWindspeed;
+    snapshot.PeakWindspeed = _peakWindspeed;
+    snapshot.Evaluation = _windspeedEvaluation;
+    snapshot.Sampling = _samplingStatus;
+    memcpy(snapshot.History, _windspeedHistoryArray, sizeof(_windspeedHistoryArray));
+}
+
+// the history is shifted in place every sample, so readers on other tasks get a copy of the published sample
+void WindSpeed::publishSnapshot()
+{
+    fillSnapshot(_publishedSnapshot.beginWrite());
+    _publishedSnapshot.endWrite();
+}
+
+// coherent copy of history, evaluation and time of the last sample, could be called from any task
+WindspeedSnapshot WindSpeed::getSnapshot()
+{
+    return _publishedSnapshot.read();
+}
+
+// the results are taken together with the sample, so the web server never reads the windows,
+// the histogram or the alarm states while the sampling tick updates them
+void WindSpeed::publishStatistics()
+{
+    WindspeedStatistics &statistics = _publishedStatistics.beginWrite();
+    statistics.SampleRate = _sampleRate;
+    statistics.LowerWindspeedThreshold = _windspeedLowerThreshold;
+    statistics.UpperWindspeedThreshold = _windspeedUpperThreshold;
+    statistics.NumberOfWindows = _windowStatistics.getNumberOfWindows();
+    for (size_t i = 0; i < statistics.NumberOfWindows; i++)
+    {
+        statistics.Windows[i] = _windowStatistics.getResult(i);
+    }
+    statistics.NumberOfHistogramSamples = _windspeedHistogram.getNumberOfSamples();
+    statistics.NumberOfSamplesAbove = _windspeedHistogram.getNumberOfSamplesAbove(_windspeedUpperThreshold * 10);
+    statistics.NumberOfSamplesBelow = _windspeedHistogram.getNumberOfSamplesBelow(_windspeedLowerThreshold * 10);
+    statistics.P50 = _windspeedHistogram.getPercentile(50);
+    statistics.P90 = _windspeedHistogram.getPercentile(90);
+    statistics.P95 = _windspeedHistogram.getPercentile(95);
+    statistics.HighestBin = _windspeedHistogram.getHighestBin();
+    for (size_t i = 0; i <= statistics.HighestBin; i++)
+    {
+        statistics.Counts[i] = _windspeedHistogram.getCount(i);
+    }
+    statistics.NumberOfAlarmRules = _alarmRules.getEvaluatedRules(statistics.AlarmRules, statistics.IsAlarmActive, ALARM_MAX_RULES);
+    _publishedStatistics.endWrite();
+}
+
+uint32_t WindSpeed::getDroppedSnapshotCount()
+{
+    return _droppedSnapshotCount;
+}
+
+bool WindSpeed::isSDCardReady()
+{
+    return _isSDCardReady;
+}
+
+// accumulated pulse count of the pulse source
+uint32_t WindSpeed::getPulseCount()
+{
+    return _lastCounter;
+}
+
+// pulse frequency in Hz of the last sample
+float WindSpeed::getPulseFrequency()
+{
+    return _pulseFrequency / 1000.0f;
+}
+
+uint32_t WindSpeed::getPulseGlitchCount()
+{
+    return _pulseCapture.getGlitchCount();
+}
+
+uint32_t WindSpeed::getPulseOverrunCount()
+{
+    return _pulseCapture.getOverrunCount();
+}
+
+SamplingStatus WindSpeed::getSamplingStatus()
+{
+    return _samplingStatus;
 }
 
 void WindSpeed::updateSettings(uint16_t windspeedLowerThreshold, uint16_t windspeedUpperThreshold, uint16_t windspeedDurationRange, uint16_t evaluationRange, uint16_t numberOfWindowsThreshold, uint16_t calibrationFactor)
 {
+    uint16_t previousEvaluationRange = _evaluationRange;
     _windspeedLowerThreshold = windspeedLowerThreshold;
     _windspeedUpperThreshold = windspeedUpperThreshold;
     _windspeedDurationRange = windspeedDurationRange;
     _evaluationRange = evaluationRange;
     _numberOfWindowsThreshold = numberOfWindowsThreshold;
     _calibrationFactor = calibrationFactor;
+    _calibrationCurve.setCalibrationFactor(_calibrationFactor);
+    applyLimits();
+    if (_evaluationRange != previousEvaluationRange)
+    {
+        rebuildHistogram();
+        _windspeedTrend.reset();
+    }
+}
+
+// keeps the settings inside the compile time buffer sizes of WindSpeedConfig
+void WindSpeed::applyLimits()
+{
+    _evaluationRange = constrain(_evaluationRange, WindSpeedConfig::MIN_DURATION_RANGE, WindSpeedConfig::MAX_EVALUATION_RANGE);
+    _windspeedDurationRange = constrain(_windspeedDurationRange, WindSpeedConfig::MIN_DURATION_RANGE, _evaluationRange);
+}
+
+// histogram of the evaluated history elements 1.._evaluationRange, only needed if the range changes
+void WindSpeed::rebuildHistogram()
+{
+    _windspeedHistogram.reset();
+    for (size_t i = _evaluationRange; i > 0; --i)
+    {
+        _windspeedHistogram.push(_windspeedHistoryArray[i]);
+    }
 }
 
 void WindSpeed::setupSDCard()
 {
+    TRACE_SPAN("mount_sd");
+    SpiBusLock lock(_spiBus, SpiBusPriority::LOGGING, SPI_BUS_LOGGING_TIMEOUT);
+    if (!lock.isAcquired())
+    {
+        Serial.println("Card Mount Failed, spi bus busy");
+        return;
+    }
     if (!SD.begin(GPIO_NUM_4, SPI, 25000000))
     {
         Serial.println("Card Mount Failed");
@@ -64,35 +257,98 @@ void WindSpeed::setupSDCard()
     Serial.printf("Used space: %lluMB\n", SD.usedBytes() / (1024 * 1024));
 
     createDir(SD, "/logs");
+    _isSDCardReady = true;
 }
 
-void WindSpeed::setupInterruptCallback(void (*externalInterruptCallback)(void))
+// without a pulse source the gpio interrupt backend on the sensor pin is used
+void WindSpeed::setupPulseSource(PulseSource *pulseSource)
 {
-    attachInterrupt(digitalPinToInterrupt(_sensorPin), externalInterruptCallback, RISING);
+    _pulseSource = pulseSource != nullptr ? pulseSource : &_interruptPulseSource;
+    _pulseSource->setupPulseCapture(&_pulseCapture);
+    _pulseSource->begin();
+    _pulseCapture.reset();
+    _lastCounter = getPulseSourceCount();
+    _lastSampleTime = millis();
+    publishSnapshot();
 }
 
-void WindSpeed::setupEvaluationCallback(std::function<void(void)> evaluationCallback)
+// called once per activation of an alarm rule, snapshots are handled here
+void WindSpeed::setupAlarmCallback(std::function<void(uint8_t, const AlarmRule &)> alarmCallback)
 {
-    _evaluationCallback = evaluationCallback;
+    _alarmCallback = alarmCallback;
 }
 
-// interrupt callback function for impuls counter of windspeed sensor
-void WindSpeed::interruptCallback()
+// all sd card accesses are arbitrated with the display and the downloads
+void WindSpeed::setupSpiBus(SpiBus *spiBus)
 {
-    _counter++;
+    _spiBus = spiBus;
 }
 
-// windspeed in m/s
+// the duration of the log file appends is recorded in the metrics
+void WindSpeed::setupMetrics(Metrics *metrics)
+{
+    _metrics = metrics;
+}
+
+// battery values of the log file are read from the telemetry
+void WindSpeed::setupTelemetry(Telemetry *telemetry)
+{
+    _telemetry = telemetry;
+}
+
+bool WindSpeed::setAlarmRules(const AlarmRule *rules, uint8_t numberOfRules)
+{
+    return _alarmRules.setRules(rules, numberOfRules);
+}
+
+uint8_t WindSpeed::getAlarmRules(AlarmRule *rules, uint8_t maxNumberOfRules)
+{
+    return _alarmRules.getRules(rules, maxNumberOfRules);
+}
+
+void WindSpeed::handleAlarmAction(uint8_t ruleIndex, const AlarmRule &rule)
+{
+    if (_alarmCallback != nullptr)
+    {
+        _alarmCallback(ruleIndex, rule);
+    }
+    if (rule.Actions & ALARM_ACTION_SNAPSHOT)
+    {
+        queueSnapshot();
+    }
+}
+
+// window lengths in samples, memory for all windows is allocated once here
+bool WindSpeed::setupStatisticsWindows(const uint16_t *lengths, uint8_t numberOfWindows)
+{
+    return _windowStatistics.setupWindows(lengths, numberOfWindows);
+}
+
+// windspeed through the calibration curve, pulse frequency in mHz and windspeed in mm/s,
+// the pulses are normalised by the real elapsed time so a late sample is not too fast
 void WindSpeed::calculateWindspeed(bool evaluate, bool log)
 {
-    float windspeed = ((float)(_counter - _lastCounter) / 20.0f * 1.75f * 1000 / _sampleRate);
-    _lastCounter = _counter;
+    _clock.update(now());
+    uint32_t interval = updateSamplingStatus();
+    updatePulseCapture();
+    uint32_t counter = getPulseSourceCount();
+    uint32_t frequency = (uint32_t)((uint64_t)(counter - _lastCounter) * 1000000ULL / interval);
+    uint32_t windspeed = _calibrationCurve.getWindspeed(frequency);
+    _pulseFrequency = frequency;
+    _lastCounter = counter;
     updateWindspeedArray(windspeed);
+    _windspeedTrend.push(_windspeedHistoryArray[0], _windspeedHistoryArray[TREND_SLOPE_RANGE]);
+    // without edge timestamps the sample itself is the best available gust value
+    bool hasGust = _pulseSource != nullptr && _pulseSource->hasEdgeTimestamps();
+    _windowStatistics.push(_windspeedHistoryArray[0], hasGust ? _gustValue : _windspeedHistoryArray[0]);
     if (evaluate)
     {
         evaluateWindspeed();
     }
-    if (log)
+    publishSnapshot();
+    publishStatistics();
+    // the sd card is mounted by a boot task while the sampling is already running
+    if (log && _isSDCardReady)
     {
         logWindspeedToSDCard(SD);
     }
@@ -104,11 +360,102 @@ float WindSpeed::getCurrentWindspeed()
     return currentWindspeed;
 }
 
+// highest 3s mean windspeed in m/s during the last sample
+float WindSpeed::getGustWindspeed()
+{
+    return _gustWindspeed;
+}
+
+// highest 250ms mean windspeed in m/s during the last sample
+float WindSpeed::getPeakWindspeed()
+{
+    return _peakWindspeed;
+}
+
+// interval in ms since the last sample, a blocked loop shows up as late sample or as gap
+uint32_t WindSpeed::updateSamplingStatus()
+{
+    uint32_t sampleTime = millis();
+    uint32_t interval = sampleTime - _lastSampleTime;
+    _lastSampleTime = sampleTime;
+    if (interval == 0)
+    {
+        interval = _sampleRate;
+    }
+
+    _samplingStatus.LastInterval = interval;
+    _samplingStatus.NumberOfSamples++;
+    if (interval >= 2 * (uint32_t)_sampleRate)
+    {
+        _samplingStatus.LastQuality = SAMPLE_QUALITY_GAP;
+        _samplingStatus.NumberOfGaps++;
+        _samplingStatus.NumberOfMissedSamples += interval / _sampleRate - 1;
+        TRACE_INSTANT("sample_gap");
+        Serial.printf("Sample gap of %u ms\n", interval);
+    }
+    else if (interval > _sampleRate + SAMPLE_LATE_TOLERANCE)
+    {
+        _samplingStatus.LastQuality = SAMPLE_QUALITY_LATE;
+        _samplingStatus.NumberOfLateSamples++;
+    }
+    else
+    {
+        _samplingStatus.LastQuality = SAMPLE_QUALITY_OK;
+    }
+    return interval;
+}
+
+// with edge timestamps the accepted edges of the capture are counted, so the sampled windspeed
+// does not include the glitches which are already rejected for gust and peak
+uint32_t WindSpeed::getPulseSourceCount()
+{
+    if (_pulseSource == nullptr)
+    {
+        return _lastCounter;
+    }
+    return _pulseSource->hasEdgeTimestamps() ? _pulseCapture.getEdgeCount() : _pulseSource->getCount();
+}
+
+// drains the capture buffer, called from every loop so the buffer only has to hold the edges of a stalled loop
+void WindSpeed::processPulses()
+{
+    _pulseCapture.process(micros());
+}
+
+void WindSpeed::updatePulseCapture()
+{
+    processPulses();
+    _gustWindspeed = _pulseCapture.getGustWindspeed();
+    _gustValue = toStorageValue(_calibrationCurve.getWindspeed(_pulseCapture.getGustFrequency()));
+    _peakWindspeed = _pulseCapture.getPeakWindspeed();
+    _pulseCapture.resetPeaks();
+}
+
+bool WindSpeed::setCalibrationPoints(const CalibrationPoint *points, uint8_t numberOfPoints)
+{
+    return _calibrationCurve.setPoints(points, numberOfPoints);
+}
+
+uint8_t WindSpeed::getCalibrationPoints(CalibrationPoint *points, uint8_t maxNumberOfPoints)
+{
+    uint8_t numberOfPoints = min(_calibrationCurve.getNumberOfPoints(), maxNumberOfPoints);
+    for (size_t i = 0; i < numberOfPoints; i++)
+    {
+        points[i] = _calibrationCurve.getPoint(i);
+    }
+    return numberOfPoints;
+}
+
 WindspeedEvaluation WindSpeed::getWindspeedEvaluation()
 {
     return _windspeedEvaluation;
 }
 
+WindowStatisticsResult WindSpeed::getWindowStatistics(uint8_t window)
+{
+    return _windowStatistics.getResult(window);
+}
+
 int WindSpeed::getWindSpeedHistoryArrayElement(int i)
 {
     return _windspeedHistoryArray[i];
@@ -116,6 +463,7 @@ int WindSpeed::getWindSpeedHistoryArrayElement(int i)
 
 void WindSpeed::evaluateWindspeed()
 {
+    TRACE_SPAN("evaluate");
 
     int maxWindspeed = 0;
     int minWindspeed = INT_MAX;
@@ -123,20 +471,13 @@ void WindSpeed::evaluateWindspeed()
 
     int rangeCounter = 0;
     int exceededRangesCounter = 0;
-    int numberOfRanges = _evaluationRange / _windspeedDurationRange;
-    int exceededRangesIndex[numberOfRanges];
 
-    for (size_t i = 0; i < 30; i++)
+    for (size_t i = 0; i < WindSpeedConfig::MAX_NUMBER_OF_RANGES; i++)
     {
         _windspeedEvaluation.RangeStartIndex[i] = 0;
         _windspeedEvaluation.RangeStopIndex[i] = 0;
     }
 
-    for (size_t i = 0; i < numberOfRanges; i++)
-    {
-        exceededRangesIndex[i] = 0;
-    }
-
     for (size_t i = _evaluationRange; i > 0; --i)
     {
         if (_windspeedHistoryArray[i] > maxWindspeed)
@@ -156,9 +497,10 @@ void WindSpeed::evaluateWindspeed()
             rangeCounter++;
         }
 
-        if (rangeCounter == _windspeedDurationRange)
+        if (rangeCounter == _windspeedDurationRange && exceededRangesCounter < WindSpeedConfig::MAX_NUMBER_OF_RANGES)
         {
-            exceededRangesIndex[exceededRangesCounter] = i;
+            _windspeedEvaluation.RangeStartIndex[exceededRangesCounter] = i;
+            _windspeedEvaluation.RangeStopIndex[exceededRangesCounter] = i + _windspeedDurationRange;
             exceededRangesCounter++;
             rangeCounter = 0;
         }
@@ -174,134 +516,285 @@ void WindSpeed::evaluateWindspeed()
     _windspeedEvaluation.MaxWindspeed = (float)maxWindspeed / 10.0f;
     _windspeedEvaluation.MinWindspeed = (float)minWindspeed / 10.0f;
     _windspeedEvaluation.AverageWindspeed = (float)(sumWindspeed / _evaluationRange) / 10.0f;
-    for (size_t i = 0; i < numberOfRanges; i++)
-    {
-        _windspeedEvaluation.RangeStartIndex[i] = exceededRangesIndex[i];
-        _windspeedEvaluation.RangeStopIndex[i] = exceededRangesIndex[i] + _windspeedDurationRange;
-    }
 
-    if (exceededRangesCounter < _numberOfWindowsThreshold)
-    {
-        _isCallbackAlreadySent = false;
-    }
+    AlarmInput alarmInput;
+    alarmInput.Windspeed = _windspeedHistoryArray[0];
+    alarmInput.LowerThreshold = _windspeedLowerThreshold * 10;
+    alarmInput.UpperThreshold = _windspeedUpperThreshold * 10;
+    alarmInput.NumberOfExceededRanges = exceededRangesCounter;
+    alarmInput.NumberOfWindowsThreshold = _numberOfWindowsThreshold;
+    alarmInput.History = _windspeedHistoryArray;
+    alarmInput.HistoryLength = _evaluationRange + 1;
+    _alarmRules.evaluate(alarmInput);
 
-    if (exceededRangesCounter >= _numberOfWindowsThreshold && !_isCallbackAlreadySent && _evaluationCallback != nullptr)
-    {
-        _isCallbackAlreadySent = true;
-        _evaluationCallback();
-        storeSnapshot();
-    }
+    evaluateTrend();
+}
+
+// time to crossing of the thresholds from the smoothed windspeed and the slope of the last samples
+void WindSpeed::evaluateTrend()
+{
+    static_assert(TREND_SLOPE_RANGE < WindSpeedConfig::HISTORY_LENGTH, "trend slope range must fit into the history");
+    _windspeedEvaluation.SmoothedWindspeed = _windspeedTrend.getSmoothed() / 10.0f;
+    _windspeedEvaluation.WindspeedSlope = _windspeedTrend.getSlope() / 10.0f * 1000.0f / _sampleRate;
+    // a lower threshold of 0 m/s could never be crossed
+    _windspeedEvaluation.TimeToLowerThreshold = _windspeedLowerThreshold > 0 ? toSeconds(_windspeedTrend.getSamplesToCrossing(_windspeedLowerThreshold * 10, false)) : -1.0f;
+    _windspeedEvaluation.TimeToUpperThreshold = toSeconds(_windspeedTrend.getSamplesToCrossing(_windspeedUpperThreshold * 10, true));
+}
+
+float WindSpeed::toSeconds(float samples)
+{
+    return samples < 0.0f ? samples : samples * _sampleRate / 1000.0f;
 }
 
-String WindSpeed::getWindspeedString(bool addUnitSymbol)
+void WindSpeed::formatWindspeed(TextFormatter &formatter, bool addUnitSymbol)
 {
-    char stringbuffer[100];
+    formatter.appendFixed(_windspeedHistoryArray[0], 1);
     if (addUnitSymbol)
     {
-        sprintf(stringbuffer, "%.1f m/s  ", getCurrentWindspeed());
+        formatter.append(" m/s  ");
     }
-    else
-    {
-        sprintf(stringbuffer, "%.1f", getCurrentWindspeed());
-    }
-    return String(stringbuffer);
 }
 
-String WindSpeed::getWindspeedEvaluationSingleString(float windspeedValue)
+// evaluation windspeeds are kept as float, formatted with one decimal
+void WindSpeed::formatWindspeedEvaluationValue(TextFormatter &formatter, float windspeedValue)
 {
-    char stringbuffer[100];
-    sprintf(stringbuffer, "%.1f", windspeedValue);
-    return String(stringbuffer);
+    formatter.appendFixed(lroundf(windspeedValue * 10.0f), 1);
 }
 
+// the daily log file stays open between the samples, it is closed on the day change event of the clock
 void WindSpeed::logWindspeedToSDCard(fs::FS &fs)
 {
-    if (!fs.exists(getLogFilePath().c_str()))
+    TRACE_SPAN("log");
+    MetricsTimer timer(_metrics, MetricsTiming::SD_APPEND);
+    SpiBusLock lock(_spiBus, SpiBusPriority::LOGGING, SPI_BUS_LOGGING_TIMEOUT);
+    if (!lock.isAcquired())
     {
-        writeLineToFile(fs, getLogFilePath().c_str(), getLogFileHeader().c_str());
+        Serial.println("Log row dropped, spi bus busy");
+        return;
     }
-    appendLineToFile(fs, getLogFilePath().c_str(), getLogCsvRow().c_str());
+    if (!_logFile)
+    {
+        char logFilePath[LOG_FILE_PATH_SIZE];
+        TextFormatter logFilePathFormatter(logFilePath, sizeof(logFilePath));
+        formatLogFilePath(logFilePathFormatter);
+        bool isNewFile = !fs.exists(logFilePath);
+        if (!isNewFile && !hasLogFileHeader(fs, logFilePath))
+        {
+            renameLogFile(fs, logFilePath);
+            isNewFile = true;
+        }
+        _logFile = fs.open(logFilePath, FILE_APPEND);
+        if (!_logFile)
+        {
+            Serial.println("Failed to open file for appending");
+            return;
+        }
+        if (isNewFile)
+        {
+            _logFile.println(getLogFileHeader());
+        }
+    }
+
+    char logCsvRow[LOG_CSV_ROW_SIZE];
+    TextFormatter logCsvRowFormatter(logCsvRow, sizeof(logCsvRow));
+    formatLogCsvRow(logCsvRowFormatter);
+    if (!_logFile.println(logCsvRow))
+    {
+        Serial.println("Append failed");
+        _logFile.close();
+        return;
+    }
+    _logFile.flush();
 }
 
-String WindSpeed::getWindspeedEvaluationString()
+void WindSpeed::formatWindspeedEvaluation(TextFormatter &formatter)
 {
-    return "MAX:" + getWindspeedEvaluationSingleString(_windspeedEvaluation.MaxWindspeed) + " MIN:" + getWindspeedEvaluationSingleString(_windspeedEvaluation.MinWindspeed) + " AVG:" + getWindspeedEvaluationSingleString(_windspeedEvaluation.AverageWindspeed);
+    formatter.append("MAX:");
+    formatWindspeedEvaluationValue(formatter, _windspeedEvaluation.MaxWindspeed);
+    formatter.append(" MIN:");
+    formatWindspeedEvaluationValue(formatter, _windspeedEvaluation.MinWindspeed);
+    formatter.append(" AVG:");
+    formatWindspeedEvaluationValue(formatter, _windspeedEvaluation.AverageWindspeed);
 }
 
-String WindSpeed::getTimestampString()
+// timestamp of the current sample from the clock
+void WindSpeed::formatTimestamp(TextFormatter &formatter)
 {
-    time_t t = now();
-    return getTimestampString(t);
+    formatter.append(_clock.getTimestamp());
 }
 
-String WindSpeed::getTimestampString(time_t time)
+// any other time is broken down into a local struct, also called from the snapshot task
+void WindSpeed::formatTimestamp(TextFormatter &formatter, time_t time, char dateTimeSeparator, char timeSeparator)
 {
-    char stringbuffer[100];
-    sprintf(stringbuffer, "%4u-%02u-%02u %02u:%02u:%02u", year(time), month(time), day(time), hour(time), minute(time), second(time));
-    return String(stringbuffer);
+    ClockDateTime dateTime;
+    Clock::toDateTime(time, dateTime);
+    formatter.appendDateTime(dateTime.Year, dateTime.Month, dateTime.Day, dateTime.Hour, dateTime.Minute, dateTime.Second, dateTimeSeparator, timeSeparator);
 }
 
-void WindSpeed::storeCsvSnapshot()
+// false if the file of the day was started with other columns, e.g. by a previous firmware
+bool WindSpeed::hasLogFileHeader(fs::FS &fs, const char *logFilePath)
 {
-    String csvFilePath = getSnapshotFilePath("csv");
-    time_t time = now();
-    String content;
-    content = getSnapshotLogFileHeader() + String("\r\n");
-    for (size_t i = 0; i < _evaluationRange; i++)
+    File logFile = fs.open(logFilePath, FILE_READ);
+    if (!logFile)
+    {
+        return false;
+    }
+    char header[LOG_FILE_HEADER_SIZE];
+    size_t length = logFile.readBytesUntil('\n', header, sizeof(header) - 1);
+    logFile.close();
+    if (length > 0 && header[length - 1] == '\r')
     {
-        content += getSnapshotCsvRow(time - _evaluationRange + 1 + i, _windspeedHistoryArray[_evaluationRange - 1 - i] / 10.0f, ',') + String("\r\n");
+        length--;
     }
-    appendFile(SD, csvFilePath.c_str(), content.c_str());
+    header[length] = '\0';
+    return strcmp(header, getLogFileHeader()) == 0;
 }
 
-void WindSpeed::storeJsonSnapshot()
+// the rows with the other columns are kept in the next free numbered file of the day,
+// if there is none the new header is appended to the existing file
+void WindSpeed::renameLogFile(fs::FS &fs, const char *logFilePath)
 {
-    String jsonFilePath = getSnapshotFilePath("json");
-    writeFile(SD, jsonFilePath.c_str(), getWindspeedJson().c_str());
+    char renamedLogFilePath[LOG_FILE_PATH_SIZE];
+    for (uint8_t part = 1; part <= LOG_FILE_MAX_PARTS; part++)
+    {
+        TextFormatter renamedLogFilePathFormatter(renamedLogFilePath, sizeof(renamedLogFilePath));
+        formatLogFilePath(renamedLogFilePathFormatter, part);
+        if (!fs.exists(renamedLogFilePath))
+        {
+            if (!fs.rename(logFilePath, renamedLogFilePath))
+            {
+                Serial.println("Failed to rename log file");
+            }
+            return;
+        }
+    }
 }
 
-void WindSpeed::storeJsonEvaluationSnapshot()
+void WindSpeed::closeLogFile()
 {
-    String jsonEvaluationFilePath = getSnapshotBaseFilePath() + "_evaluation.json";
-    writeFile(SD, jsonEvaluationFilePath.c_str(), getWindspeedEvaluationJson().c_str());
+    if (_logFile)
+    {
+        SpiBusLock lock(_spiBus, SpiBusPriority::LOGGING, SPI_BUS_LOGGING_TIMEOUT);
+        _logFile.close();
+    }
 }
 
-void WindSpeed::storeSnapshot()
+const Clock &WindSpeed::getClock()
 {
-    storeJsonSnapshot();
-    storeJsonEvaluationSnapshot();
-    storeCsvSnapshot();
+    return _clock;
 }
 
-String WindSpeed::getWindspeedJson()
+// one binary snapshot file, json and csv are rendered from it on download by the SnapshotRenderer
+void WindSpeed::storeSnapshot(const WindspeedSnapshot &snapshot)
 {
-    JsonDocument jsonDocument;
+    TRACE_SPAN("store_snapshot");
+    const WindspeedEvaluation &evaluation = snapshot.Evaluation;
+    SnapshotFileHeader header;
+    header.Magic = SNAPSHOT_FILE_MAGIC;
+    header.Version = SNAPSHOT_FILE_VERSION;
+    header.HeaderSize = sizeof(SnapshotFileHeader);
+    header.Time = snapshot.Time;
+    header.SamplePeriod = snapshot.SampleRate;
+    header.NumberOfSamples = snapshot.EvaluationRange;
+    header.LowerWindspeedThreshold = snapshot.LowerWindspeedThreshold;
+    header.UpperWindspeedThreshold = snapshot.UpperWindspeedThreshold;
+    header.WindspeedDurationRange = snapshot.WindspeedDurationRange;
+    header.NumberOfWindowsThreshold = snapshot.NumberOfWindowsThreshold;
+    header.NumberOfExceededRanges = evaluation.NumberOfExceededRanges;
+    header.Reserved = 0;
+    header.CurrentWindspeed = snapshot.CurrentWindspeed;
+    header.GustWindspeed = snapshot.GustWindspeed;
+    header.PeakWindspeed = snapshot.PeakWindspeed;
+    header.MinWindspeed = evaluation.MinWindspeed;
+    header.MaxWindspeed = evaluation.MaxWindspeed;
+    header.AverageWindspeed = evaluation.AverageWindspeed;
+    header.SmoothedWindspeed = evaluation.SmoothedWindspeed;
+    header.WindspeedSlope = evaluation.WindspeedSlope;
+    header.TimeToLowerThreshold = evaluation.TimeToLowerThreshold;
+    header.TimeToUpperThreshold = evaluation.TimeToUpperThreshold;
 
-    for (size_t i = 0; i < _evaluationRange; i++)
+    SnapshotFileRange ranges[WindSpeedConfig::MAX_NUMBER_OF_RANGES];
+    for (size_t i = 0; i < header.NumberOfExceededRanges; i++)
     {
-        JsonObject arrayDocument = jsonDocument.add<JsonObject>();
-        arrayDocument["x"] = i;
-        arrayDocument["y"] = _windspeedHistoryArray[_evaluationRange - 1 - i] / 10.0f;
+        ranges[i].StartIndex = evaluation.RangeStartIndex[i];
+        ranges[i].StopIndex = evaluation.RangeStopIndex[i];
     }
 
-    String jsonString;
-    jsonDocument.shrinkToFit();
-    serializeJson(jsonDocument, jsonString);
+    // oldest sample first
+    int16_t samples[WindSpeedConfig::HISTORY_LENGTH];
+    for (size_t i = 0; i < header.NumberOfSamples; i++)
+    {
+        samples[i] = snapshot.History[header.NumberOfSamples - 1 - i];
+    }
 
-    return jsonString;
+    char snapshotFilePath[SNAPSHOT_FILE_PATH_SIZE];
+    TextFormatter snapshotFilePathFormatter(snapshotFilePath, sizeof(snapshotFilePath));
+    formatSnapshotFilePath(snapshotFilePathFormatter, snapshot.Time);
+    Serial.printf("Writing snapshot %s\n", snapshotFilePath);
+    File file = SD.open(snapshotFilePath, FILE_WRITE);
+    if (!file)
+    {
+        Serial.println("Failed to open file for writing");
+        return;
+    }
+    size_t length = sizeof(header) + header.NumberOfExceededRanges * sizeof(SnapshotFileRange) + header.NumberOfSamples * sizeof(int16_t);
+    size_t writtenLength = file.write((const uint8_t *)&header, sizeof(header));
+    writtenLength += file.write((const uint8_t *)ranges, header.NumberOfExceededRanges * sizeof(SnapshotFileRange));
+    writtenLength += file.write((const uint8_t *)samples, header.NumberOfSamples * sizeof(int16_t));
+    if (writtenLength != length)
+    {
+        Serial.println("Write failed");
+    }
+    file.close();
 }
 
-String WindSpeed::getWindspeedEvaluationJson()
+void WindSpeed::addWindspeedJson(JsonDocument &jsonDocument)
 {
-    WindspeedEvaluation windspeedEvaluation = getWindspeedEvaluation();
+    WindspeedSnapshot snapshot = getSnapshot();
 
-    JsonDocument jsonDocument;
+    for (size_t i = 0; i < snapshot.EvaluationRange; i++)
+    {
+        JsonObject arrayDocument = jsonDocument.add<JsonObject>();
+        arrayDocument["x"] = i;
+        arrayDocument["y"] = snapshot.History[snapshot.EvaluationRange - 1 - i] / 10.0f;
+    }
+}
 
-    jsonDocument["Current"] = getCurrentWindspeed();
+void WindSpeed::addWindspeedEvaluationJson(JsonDocument &jsonDocument)
+{
+    WindspeedSnapshot snapshot = getSnapshot();
+    addWindspeedEvaluationJson(jsonDocument, snapshot.Evaluation, snapshot.CurrentWindspeed, snapshot.GustWindspeed, snapshot.PeakWindspeed);
+}
+
+void WindSpeed::addWindspeedEvaluationJson(JsonDocument &jsonDocument, const WindspeedEvaluation &windspeedEvaluation, float currentWindspeed, float gustWindspeed, float peakWindspeed)
+{
+    jsonDocument["Current"] = currentWindspeed;
+    jsonDocument["Gust"] = gustWindspeed;
+    jsonDocument["Peak"] = peakWindspeed;
     jsonDocument["Min"] = windspeedEvaluation.MinWindspeed;
     jsonDocument["Max"] = windspeedEvaluation.MaxWindspeed;
     jsonDocument["Average"] = windspeedEvaluation.AverageWindspeed;
 
+    JsonObject trend = jsonDocument["Trend"].to<JsonObject>();
+    trend["Smoothed"] = windspeedEvaluation.SmoothedWindspeed;
+    trend["Slope"] = windspeedEvaluation.WindspeedSlope;
+    if (windspeedEvaluation.TimeToLowerThreshold >= 0.0f)
+    {
+        trend["TimeToLowerThreshold"] = windspeedEvaluation.TimeToLowerThreshold;
+    }
+    else
+    {
+        trend["TimeToLowerThreshold"] = nullptr;
+    }
+    if (windspeedEvaluation.TimeToUpperThreshold >= 0.0f)
+    {
+        trend["TimeToUpperThreshold"] = windspeedEvaluation.TimeToUpperThreshold;
+    }
+    else
+    {
+        trend["TimeToUpperThreshold"] = nullptr;
+    }
+
     JsonArray exceededRanges = jsonDocument["ExceededRanges"].to<JsonArray>();
     for (size_t i = 0; i < windspeedEvaluation.NumberOfExceededRanges; i++)
     {
@@ -310,62 +803,143 @@ String WindSpeed::getWindspeedEvaluationJson()
         exceedingRange["StartIndex"] = windspeedEvaluation.RangeStartIndex[i];
         exceedingRange["StopIndex"] = windspeedEvaluation.RangeStopIndex[i];
     }
+}
+
+void WindSpeed::addWindowStatisticsJson(JsonDocument &jsonDocument)
+{
+    WindspeedStatistics statistics = _publishedStatistics.read();
 
-    String jsonString;
-    jsonDocument.shrinkToFit();
-    serializeJson(jsonDocument, jsonString);
-    return jsonString;
+    for (size_t i = 0; i < statistics.NumberOfWindows; i++)
+    {
+        const WindowStatisticsResult &result = statistics.Windows[i];
+        JsonObject window = jsonDocument.add<JsonObject>();
+        window["Duration"] = (uint32_t)result.Length * statistics.SampleRate / 1000;
+        window["NumberOfSamples"] = result.NumberOfSamples;
+        window["Average"] = result.NumberOfSamples > 0 ? (float)result.Sum / result.NumberOfSamples / 10.0f : 0.0f;
+        window["Min"] = result.Min / 10.0f;
+        window["Max"] = result.Max / 10.0f;
+        window["Gust"] = result.Gust / 10.0f;
+    }
 }
 
-String WindSpeed::getSnapshotCsvRow(time_t time, float windspeedValue, char separationChar)
+void WindSpeed::addWindspeedHistogramJson(JsonDocument &jsonDocument)
 {
-    return getTimestampString(time) + separationChar + getWindspeedEvaluationSingleString(windspeedValue);
+    WindspeedStatistics statistics = _publishedStatistics.read();
+    uint32_t numberOfSamples = statistics.NumberOfHistogramSamples;
+
+    jsonDocument["BinWidth"] = 1.0f / WindSpeedConfig::STORAGE_SCALE;
+    jsonDocument["NumberOfSamples"] = numberOfSamples;
+    jsonDocument["P50"] = statistics.P50 / 10.0f;
+    jsonDocument["P90"] = statistics.P90 / 10.0f;
+    jsonDocument["P95"] = statistics.P95 / 10.0f;
+    if (numberOfSamples > 0)
+    {
+        jsonDocument["AboveUpperThreshold"] = (float)statistics.NumberOfSamplesAbove / numberOfSamples;
+        jsonDocument["BelowLowerThreshold"] = (float)statistics.NumberOfSamplesBelow / numberOfSamples;
+    }
+
+    JsonArray counts = jsonDocument["Counts"].to<JsonArray>();
+    for (size_t i = 0; i <= statistics.HighestBin; i++)
+    {
+        counts.add(statistics.Counts[i]);
+    }
 }
 
-String WindSpeed::getLogCsvRow(char separationChar)
+// a replaced rule table is reported inactive until the sampling tick evaluated it
+void WindSpeed::addAlarmRulesJson(JsonDocument &jsonDocument)
 {
-    return getTimestampString() + separationChar + getWindspeedString() + separationChar + String(M5.Power.getBatteryLevel()) + separationChar + String(M5.Power.getBatteryVoltage());
+    AlarmRule rules[ALARM_MAX_RULES];
+    uint8_t numberOfRules = _alarmRules.getRules(rules, ALARM_MAX_RULES);
+    WindspeedStatistics statistics = _publishedStatistics.read();
+
+    for (size_t i = 0; i < numberOfRules; i++)
+    {
+        AlarmRule &rule = rules[i];
+        JsonObject ruleJson = jsonDocument.add<JsonObject>();
+        ruleJson["Type"] = ALARM_RULE_TYPE_NAMES[(uint8_t)rule.Type];
+        ruleJson["Comparison"] = ALARM_COMPARISON_NAMES[(uint8_t)rule.Comparison];
+        ruleJson["Threshold"] = rule.Type == AlarmRuleType::EXCEEDED_WINDOWS ? rule.Threshold : rule.Threshold / 10.0f;
+        ruleJson["ReleaseThreshold"] = rule.ReleaseThreshold / 10.0f;
+        ruleJson["Duration"] = rule.Duration;
+        ruleJson["SoundPattern"] = rule.SoundPattern;
+        ruleJson["IsActive"] = i < statistics.NumberOfAlarmRules && statistics.IsAlarmActive[i] && memcmp(&statistics.AlarmRules[i], &rule, sizeof(AlarmRule)) == 0;
+        JsonArray actions = ruleJson["Actions"].to<JsonArray>();
+        for (size_t j = 0; j < sizeof(ALARM_ACTION_NAMES) / sizeof(ALARM_ACTION_NAMES[0]); j++)
+        {
+            if (rule.Actions & (1 << j))
+            {
+                actions.add(ALARM_ACTION_NAMES[j]);
+            }
+        }
+    }
 }
 
-String WindSpeed::getSnapshotBaseFilePath()
+void WindSpeed::addCalibrationJson(JsonDocument &jsonDocument)
 {
-    time_t t = now();
-    char stringbuffer[100];
-    sprintf(stringbuffer, "/logs/%4u-%02u-%02u_%02u-%02u-%02u_windspeed_snapshot", year(t), month(t), day(t), hour(t), minute(t), second(t));
-    return String(stringbuffer);
+    jsonDocument["CalibrationFactor"] = _calibrationFactor;
+    JsonArray points = jsonDocument["Points"].to<JsonArray>();
+    for (size_t i = 0; i < _calibrationCurve.getNumberOfPoints(); i++)
+    {
+        CalibrationPoint calibrationPoint = _calibrationCurve.getPoint(i);
+        JsonObject point = points.add<JsonObject>();
+        point["Frequency"] = calibrationPoint.Frequency / 1000.0f;
+        point["Windspeed"] = calibrationPoint.Windspeed / 1000.0f;
+    }
 }
 
-String WindSpeed::getSnapshotFilePath(String fileType)
+void WindSpeed::formatLogCsvRow(TextFormatter &formatter, char separationChar)
 {
-    return getSnapshotBaseFilePath() + "." + fileType;
+    formatTimestamp(formatter);
+    formatter.append(separationChar);
+    formatWindspeed(formatter);
+    TelemetryData telemetryData = _telemetry != nullptr ? _telemetry->getData() : TelemetryData();
+    formatter.append(separationChar).appendInteger(telemetryData.BatteryLevel);
+    formatter.append(separationChar).appendInteger(telemetryData.BatteryVoltage);
+    formatter.append(separationChar).appendUnsigned(_samplingStatus.LastInterval);
+    formatter.append(separationChar).appendUnsigned(_samplingStatus.LastQuality);
 }
 
-String WindSpeed::getSnapshotLogFileHeader()
+void WindSpeed::formatSnapshotFilePath(TextFormatter &formatter, time_t time)
 {
-    return "Timestamp(UTC), Windspeed[m/s]";
+    formatter.append("/logs/");
+    formatTimestamp(formatter, time, '_', '-');
+    formatter.append("_windspeed_snapshot").append(SNAPSHOT_FILE_EXTENSION);
 }
 
-String WindSpeed::getLogFilePath()
+void WindSpeed::formatLogFilePath(TextFormatter &formatter, uint8_t part)
 {
-    time_t t = now();
-    char stringbuffer[100];
-    sprintf(stringbuffer, "/logs/%4u-%02u-%02u_windspeed.csv", year(t), month(t), day(t));
-    return String(stringbuffer);
+    formatter.append("/logs/").append(_clock.getDate()).append("_windspeed");
+    if (part > 0)
+    {
+        formatter.append('_').appendUnsigned(part);
+    }
+    formatter.append(".csv");
 }
 
-String WindSpeed::getLogFileHeader()
+const char *WindSpeed::getLogFileHeader()
 {
-    return "Timestamp(UTC), Windspeed[m/s], BatteryLevel[%], BatteryVoltage[mV]";
+    return "Timestamp(UTC), Windspeed[m/s], BatteryLevel[%], BatteryVoltage[mV], SampleInterval[ms], SampleQuality";
 }
 
-void WindSpeed::updateWindspeedArray(float currentWindspeed)
+// windspeed in mm/s, stored in 0.1 m/s
+void WindSpeed::updateWindspeedArray(uint32_t currentWindspeed)
 {
-    for (size_t i = _evaluationRange; i > 0; --i)
+    // element _evaluationRange leaves and element 0 enters the evaluated range, the history is
+    // shifted at least over the trend slope range, so the trend evicts the real sample of a short range
+    _windspeedHistogram.evict(_windspeedHistoryArray[_evaluationRange]);
+    _windspeedHistogram.push(_windspeedHistoryArray[0]);
+    for (size_t i = max(_evaluationRange, (uint16_t)TREND_SLOPE_RANGE); i > 0; --i)
     {
         _windspeedHistoryArray[i] = _windspeedHistoryArray[i - 1];
     }
-    int calculatedWindspeed = (int)(currentWindspeed * 10.0f);
-    _windspeedHistoryArray[0] = calculatedWindspeed;
+    _windspeedHistoryArray[0] = toStorageValue(currentWindspeed);
+}
+
+// windspeed in mm/s to the history storage unit of 0.1 m/s
+WindSpeedConfig::StorageType WindSpeed::toStorageValue(uint32_t windspeed)
+{
+    uint32_t storageValue = (windspeed * WindSpeedConfig::STORAGE_SCALE + 500) / 1000;
+    return (WindSpeedConfig::StorageType)min(storageValue, (uint32_t)WindSpeedConfig::MAX_STORAGE_VALUE);
 }
 
 void WindSpeed::createDir(fs::FS &fs, const char *path)
@@ -399,83 +973,3 @@ void WindSpeed::readFile(fs::FS &fs, const char *path)
     }
     file.close();
 }
-
-void WindSpeed::writeFile(fs::FS &fs, const char *path, const char *message)
-{
-    Serial.printf("Writing file: %s\n", path);
-
-    File file = fs.open(path, FILE_WRITE);
-    if (!file)
-    {
-        Serial.println("Failed to open file for writing");
-        return;
-    }
-    if (file.print(message))
-    {
-        Serial.println("File written");
-    }
-    else
-    {
-        Serial.println("Write failed");
-    }
-    file.close();
-}
-
-void WindSpeed::writeLineToFile(fs::FS &fs, const char *path, const char *message)
-{
-    Serial.printf("Writing file: %s\n", path);
-
-    File file = fs.open(path, FILE_WRITE);
-    if (!file)
-    {
-        Serial.println("Failed to open file for writing");
-        return;
-    }
-    if (file.println(message))
-    {
-        Serial.println("File written");
-    }
-    else
-    {
-        Serial.println("Write failed");
-    }
-    file.close();
-}
-
-void WindSpeed::appendFile(fs::FS &fs, const char *path, const char *message)
-{
-    Serial.printf("Appending to file: %s\n", path);
-
-    File file = fs.open(path, FILE_APPEND);
-    if (!file)
-    {
-        Serial.println("Failed to open file for appending");
-        return;
-    }
-    if (file.print(message))
-    {
-        Serial.println("Message appended");
-    }
-    else
-    {
-        Serial.println("Append failed");
-    }
-    file.close();
-}
-
-void WindSpeed::appendLineToFile(fs::FS &fs, const char *path, const char *message)
-{
-
-    File file = fs.open(path, FILE_APPEND);
-    if (!file)
-    {
-        Serial.println("Failed to open file for appending");
-        return;
-    }
-
-    if (!file.println(message))
-    {
-        Serial.println("Append failed");
-    }
-    file.close();
-}
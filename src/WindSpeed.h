@@ -6,6 +6,23 @@
 #include <SD.h>
 #include <ArduinoJson.h>
 #include <M5Unified.h>
+#include "WindSpeedConfig.h"
+#include "CalibrationCurve.h"
+#include "PulseCapture.h"
+#include "WindowStatistics.h"
+#include "WindspeedHistogram.h"
+#include "WindspeedTrend.h"
+#include "AlarmRules.h"
+#include "SnapshotFile.h"
+#include "TextFormatter.h"
+#include "Clock.h"
+#include "Telemetry.h"
+#include "Published.h"
+#include "SpiBus.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include "PulseSource.h"
+#include "InterruptPulseSource.h"
 
 // structs, enums
 struct WindspeedEvaluation
@@ -14,68 +31,197 @@ struct WindspeedEvaluation
     float MinWindspeed;
     float AverageWindspeed;
     int NumberOfExceededRanges;
-    int RangeStartIndex[30];
-    int RangeStopIndex[30];
+    uint16_t RangeStartIndex[WindSpeedConfig::MAX_NUMBER_OF_RANGES];
+    uint16_t RangeStopIndex[WindSpeedConfig::MAX_NUMBER_OF_RANGES];
+    float SmoothedWindspeed;
+    float WindspeedSlope;       // m/s per s
+    float TimeToLowerThreshold; // s, negative if no crossing is expected
+    float TimeToUpperThreshold; // s, negative if no crossing is expected
+};
+
+// quality flags of a sample, logged together with the actual sample interval
+#define SAMPLE_QUALITY_OK 0
+#define SAMPLE_QUALITY_LATE 1    // interval longer than the sample period plus the tolerance
+#define SAMPLE_QUALITY_GAP 2     // at least one whole sample period without a sample
+#define SAMPLE_LATE_TOLERANCE 50 // ms
+
+// interval and quality of the last sample and the counters since the start
+struct SamplingStatus
+{
+    uint32_t LastInterval; // ms
+    uint8_t LastQuality;
+    uint32_t NumberOfSamples;
+    uint32_t NumberOfLateSamples;
+    uint32_t NumberOfGaps;
+    uint32_t NumberOfMissedSamples;
+};
+
+#define SNAPSHOT_POOL_SIZE 2       // snapshots waiting to be written
+#define SNAPSHOT_TASK_STACK_SIZE 8192
+#define SNAPSHOT_TASK_PRIORITY 1
+
+// text buffer sizes of the fixed buffer formatting
+#define LOG_FILE_PATH_SIZE 40
+#define LOG_CSV_ROW_SIZE 64
+#define LOG_FILE_HEADER_SIZE 128
+#define LOG_FILE_MAX_PARTS 10 // renamed log files of a day with another header
+#define SNAPSHOT_FILE_PATH_SIZE 64
+
+// copy of everything a snapshot consists of, taken in the alarm path and written by the snapshot task,
+// the last sample is also published as snapshot for the web server task
+struct WindspeedSnapshot
+{
+    time_t Time;
+    uint16_t EvaluationRange;
+    uint16_t SampleRate;
+    uint16_t LowerWindspeedThreshold;
+    uint16_t UpperWindspeedThreshold;
+    uint16_t WindspeedDurationRange;
+    uint16_t NumberOfWindowsThreshold;
+    float CurrentWindspeed;
+    float GustWindspeed;
+    float PeakWindspeed;
+    WindspeedEvaluation Evaluation;
+    SamplingStatus Sampling;
+    WindSpeedConfig::StorageType History[WindSpeedConfig::HISTORY_LENGTH];
+};
+
+// window statistics, histogram and alarm states of the last sample, published for the web server
+// task like the snapshot, histogram counts up to HighestBin
+struct WindspeedStatistics
+{
+    uint16_t SampleRate;
+    uint16_t LowerWindspeedThreshold;
+    uint16_t UpperWindspeedThreshold;
+    uint8_t NumberOfWindows;
+    WindowStatisticsResult Windows[STATISTICS_MAX_WINDOWS];
+    uint32_t NumberOfHistogramSamples;
+    uint32_t NumberOfSamplesAbove;
+    uint32_t NumberOfSamplesBelow;
+    int16_t P50;
+    int16_t P90;
+    int16_t P95;
+    uint16_t HighestBin;
+    uint16_t Counts[HISTOGRAM_NUMBER_OF_BINS];
+    uint8_t NumberOfAlarmRules;
+    AlarmRule AlarmRules[ALARM_MAX_RULES];
+    bool IsAlarmActive[ALARM_MAX_RULES];
 };
 
 class WindSpeed
 {
 public:
     WindSpeed(uint8_t sensorPin, uint16_t windspeedLowerThreshold = 0, uint16_t windspeedUpperThreshold = 8, uint16_t windspeedDurationRange = 20, uint16_t evaluationRange = 300, uint16_t numberOfWindowsThreshold = 3, uint16_t calibrationFactor = 1);
-    void setupInterruptCallback(void (*externalInterruptCallback)(void));
-    void setupEvaluationCallback(std::function<void(void)> evaluationCallback);
+    void setupPulseSource(PulseSource *pulseSource = nullptr);
+    void setupAlarmCallback(std::function<void(uint8_t, const AlarmRule &)> alarmCallback);
+    void setupTelemetry(Telemetry *telemetry);
+    void setupSpiBus(SpiBus *spiBus);
+    void setupMetrics(Metrics *metrics);
+    bool setAlarmRules(const AlarmRule *rules, uint8_t numberOfRules);
+    uint8_t getAlarmRules(AlarmRule *rules, uint8_t maxNumberOfRules);
+    void addAlarmRulesJson(JsonDocument &jsonDocument);
+    bool setupStatisticsWindows(const uint16_t *lengths, uint8_t numberOfWindows);
     void setup();
     void updateSettings(uint16_t windspeedLowerThreshold, uint16_t windspeedUpperThreshold, uint16_t windspeedDurationRange, uint16_t evaluationRange, uint16_t numberOfWindowsThreshold, uint16_t calibrationValue);
-    void interruptCallback();
     void calculateWindspeed(bool evaluate = true, bool log = false);
+    void processPulses();
     float getCurrentWindspeed();
+    float getGustWindspeed();
+    float getPeakWindspeed();
+    WindspeedSnapshot getSnapshot();
     WindspeedEvaluation getWindspeedEvaluation();
-    String getWindspeedJson();
-    String getWindspeedEvaluationJson();
-    String getWindspeedEvaluationString();
-    String getWindspeedEvaluationString(float windspeedValue);
-    String getWindspeedString(bool addUnitSymbol = false);
+    WindowStatisticsResult getWindowStatistics(uint8_t window);
+    void addWindowStatisticsJson(JsonDocument &jsonDocument);
+    void addWindspeedHistogramJson(JsonDocument &jsonDocument);
+    void addWindspeedJson(JsonDocument &jsonDocument);
+    void addWindspeedEvaluationJson(JsonDocument &jsonDocument);
+    void formatWindspeedEvaluation(TextFormatter &formatter);
+    void formatWindspeed(TextFormatter &formatter, bool addUnitSymbol = false);
     int getWindSpeedHistoryArrayElement(int i);
-    String getTimestampString();
+    void formatTimestamp(TextFormatter &formatter);
+    const Clock &getClock();
+    bool setCalibrationPoints(const CalibrationPoint *points, uint8_t numberOfPoints);
+    uint8_t getCalibrationPoints(CalibrationPoint *points, uint8_t maxNumberOfPoints);
+    void addCalibrationJson(JsonDocument &jsonDocument);
+    uint32_t getDroppedSnapshotCount();
+    bool isSDCardReady();
+    uint32_t getPulseCount();
+    float getPulseFrequency();
+    uint32_t getPulseGlitchCount();
+    uint32_t getPulseOverrunCount();
+    SamplingStatus getSamplingStatus();
+    static void addWindspeedEvaluationJson(JsonDocument &jsonDocument, const WindspeedEvaluation &windspeedEvaluation, float currentWindspeed, float gustWindspeed, float peakWindspeed);
 
 private:
     uint8_t _sensorPin;
+    InterruptPulseSource _interruptPulseSource;
+    PulseSource *_pulseSource = nullptr;
     uint16_t _calibrationFactor = 1;
     uint16_t _evaluationRange = 300;
     uint16_t _windspeedLowerThreshold = 0;
     uint16_t _windspeedUpperThreshold = 8;
     uint16_t _windspeedDurationRange = 20;
     uint16_t _numberOfWindowsThreshold = 3;
-    uint16_t _sampleRate = 1000;
-    uint32_t _counter = 0;
+    uint16_t _sampleRate = WindSpeedConfig::SAMPLE_PERIOD;
     uint32_t _lastCounter = 0;
-    bool _isCallbackAlreadySent = false;
-    std::function<void(void)> _evaluationCallback = nullptr;
+    uint32_t _lastSampleTime = 0; // ms
+    SamplingStatus _samplingStatus = {};
+    AlarmRules _alarmRules;
+    std::function<void(uint8_t, const AlarmRule &)> _alarmCallback = nullptr;
+    Telemetry *_telemetry = nullptr;
+    SpiBus *_spiBus = nullptr;
+    Metrics *_metrics = nullptr;
+    uint32_t _pulseFrequency = 0; // mHz
+    float _gustWindspeed = 0.0f;
+    float _peakWindspeed = 0.0f;
+    CalibrationCurve _calibrationCurve;
+    PulseCapture _pulseCapture;
+    WindowStatistics _windowStatistics;
+    WindspeedHistogram _windspeedHistogram;
+    WindspeedTrend _windspeedTrend;
+    WindSpeedConfig::StorageType _gustValue = 0;
     WindspeedEvaluation _windspeedEvaluation;
-    int _windspeedHistoryArray[300];
+    WindSpeedConfig::StorageType _windspeedHistoryArray[WindSpeedConfig::HISTORY_LENGTH] = {};
+    WindspeedSnapshot _snapshotPool[SNAPSHOT_POOL_SIZE];
+    QueueHandle_t _freeSnapshotQueue = nullptr;
+    QueueHandle_t _pendingSnapshotQueue = nullptr;
+    uint32_t _droppedSnapshotCount = 0;
+    Published<WindspeedSnapshot> _publishedSnapshot;
+    Published<WindspeedStatistics> _publishedStatistics;
+    File _logFile;
+    volatile bool _isSDCardReady = false;
+    Clock _clock;
     void setupSDCard();
     void logWindspeedToSDCard(fs::FS &fs);
     void evaluateWindspeed();
-    void updateWindspeedArray(float currentWindspeed);
-    String getWindspeedEvaluationSingleString(float windspeedValue);
-    String getLogCsvRow(char separationChar = ',');
-    String getLogFilePath();
-    String getLogFileHeader();
-    void appendLineToFile(fs::FS &fs, const char *path, const char *message);
-    void appendFile(fs::FS &fs, const char *path, const char *message);
-    void writeLineToFile(fs::FS &fs, const char *path, const char *message);
-    void writeFile(fs::FS &fs, const char *path, const char *message);
+    void evaluateTrend();
+    float toSeconds(float samples);
+    void updateWindspeedArray(uint32_t currentWindspeed);
+    WindSpeedConfig::StorageType toStorageValue(uint32_t windspeed);
+    void updatePulseCapture();
+    uint32_t getPulseSourceCount();
+    uint32_t updateSamplingStatus();
+    void applyLimits();
+    void rebuildHistogram();
+    void formatWindspeedEvaluationValue(TextFormatter &formatter, float windspeedValue);
+    void formatLogCsvRow(TextFormatter &formatter, char separationChar = ',');
+    void formatLogFilePath(TextFormatter &formatter, uint8_t part = 0);
+    void closeLogFile();
+    const char *getLogFileHeader();
+    bool hasLogFileHeader(fs::FS &fs, const char *logFilePath);
+    void renameLogFile(fs::FS &fs, const char *logFilePath);
     void readFile(fs::FS &fs, const char *path);
     void createDir(fs::FS &fs, const char *path);
-    void storeSnapshot();
-    void storeJsonSnapshot();
-    void storeJsonEvaluationSnapshot();
-    void storeCsvSnapshot();
-    String getSnapshotCsvRow(time_t time, float windspeedValue, char separationChar = ',');
-    String getSnapshotFilePath(String fileType);
-    String getSnapshotLogFileHeader();
-    String getTimestampString(time_t time);
-    String getSnapshotBaseFilePath();
+    void handleAlarmAction(uint8_t ruleIndex, const AlarmRule &rule);
+    void setupSnapshotTask();
+    static void snapshotTask(void *parameter);
+    void queueSnapshot();
+    void fillSnapshot(WindspeedSnapshot &snapshot);
+    void publishSnapshot();
+    void publishStatistics();
+    void storeSnapshot(const WindspeedSnapshot &snapshot);
+    void formatSnapshotFilePath(TextFormatter &formatter, time_t time);
+    void formatTimestamp(TextFormatter &formatter, time_t time, char dateTimeSeparator = ' ', char timeSeparator = ':');
 };
 
 #endif
\ No newline at end of file
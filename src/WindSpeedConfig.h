@@ -0,0 +1,77 @@
+#ifndef WindSpeedConfig_h
+#define WindSpeedConfig_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <limits>
+
+// build time configuration, could be overridden with build flags
+#ifndef WINDSPEED_MAX_EVALUATION_RANGE
+#define WINDSPEED_MAX_EVALUATION_RANGE 300 // samples
+#endif
+#ifndef WINDSPEED_SAMPLE_PERIOD
+#define WINDSPEED_SAMPLE_PERIOD 1000 // ms
+#endif
+#ifndef WINDSPEED_MIN_DURATION_RANGE
+#define WINDSPEED_MIN_DURATION_RANGE 10 // samples
+#endif
+
+// compile time limits of the windspeed evaluation, all buffer sizes are derived from them
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+struct WindSpeedLimits
+{
+    typedef Storage StorageType;
+
+    static constexpr uint16_t MAX_EVALUATION_RANGE = MaxEvaluationRange;
+    static constexpr uint16_t SAMPLE_PERIOD = SamplePeriod;
+    static constexpr uint16_t MIN_DURATION_RANGE = MinDurationRange;
+
+    // index 0 holds the current sample, indices 1..MAX_EVALUATION_RANGE are evaluated
+    static constexpr size_t HISTORY_LENGTH = MaxEvaluationRange + 1;
+    static constexpr size_t MAX_NUMBER_OF_RANGES = MaxEvaluationRange / MinDurationRange;
+
+    // windspeed sensor: 20 pulses per revolution, one revolution per second equals 1.75 m/s
+    static constexpr float PULSES_PER_REVOLUTION = 20.0f;
+    static constexpr float WINDSPEED_PER_REVOLUTION = 1.75f;
+    static constexpr float WINDSPEED_PER_HERTZ = WINDSPEED_PER_REVOLUTION / PULSES_PER_REVOLUTION;
+
+    // history values are stored in 0.1 m/s
+    static constexpr int STORAGE_SCALE = 10;
+    static constexpr int MAX_STORAGE_VALUE = std::numeric_limits<Storage>::max();
+    static constexpr int MAX_WINDSPEED = 100; // m/s
+
+    static_assert(MaxEvaluationRange > 0, "evaluation range must not be empty");
+    static_assert(SamplePeriod > 0, "sample period must not be zero");
+    static_assert(MinDurationRange > 0 && MinDurationRange <= MaxEvaluationRange, "minimum duration range must fit into the evaluation range");
+    static_assert(std::numeric_limits<Storage>::is_integer && std::numeric_limits<Storage>::is_signed, "storage type must be a signed integer");
+    static_assert(MAX_STORAGE_VALUE >= MAX_WINDSPEED * STORAGE_SCALE, "storage type too small for the windspeed range");
+    static_assert(MAX_NUMBER_OF_RANGES <= std::numeric_limits<uint16_t>::max(), "too many evaluation ranges");
+};
+
+// definitions for odr-used members (C++11)
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr uint16_t WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::MAX_EVALUATION_RANGE;
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr uint16_t WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::SAMPLE_PERIOD;
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr uint16_t WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::MIN_DURATION_RANGE;
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr size_t WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::HISTORY_LENGTH;
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr size_t WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::MAX_NUMBER_OF_RANGES;
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr float WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::PULSES_PER_REVOLUTION;
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr float WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::WINDSPEED_PER_REVOLUTION;
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr float WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::WINDSPEED_PER_HERTZ;
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr int WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::STORAGE_SCALE;
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr int WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::MAX_STORAGE_VALUE;
+template <uint16_t MaxEvaluationRange, uint16_t SamplePeriod, uint16_t MinDurationRange, typename Storage>
+constexpr int WindSpeedLimits<MaxEvaluationRange, SamplePeriod, MinDurationRange, Storage>::MAX_WINDSPEED;
+
+typedef WindSpeedLimits<WINDSPEED_MAX_EVALUATION_RANGE, WINDSPEED_SAMPLE_PERIOD, WINDSPEED_MIN_DURATION_RANGE, int16_t> WindSpeedConfig;
+
+#endif
@@ -10,6 +10,16 @@ WindSpeedDisplay::WindSpeedDisplay(uint16_t lowerWindspeedThreshold, uint16_t up
     _currentDrawType = DrawType::COMBINED;
 }
 
+void WindSpeedDisplay::setupTelemetry(Telemetry *telemetry)
+{
+    _telemetry = telemetry;
+}
+
+void WindSpeedDisplay::setupMetrics(Metrics *metrics)
+{
+    _metrics = metrics;
+}
+
 void WindSpeedDisplay::setup()
 {
     _display.setBrightness(255);
@@ -73,6 +83,10 @@ void WindSpeedDisplay::draw(DrawType drawType)
         drawQRCode();
         break;
 
+    case DrawType::METRICS:
+        drawMetricsView();
+        break;
+
     default:
         drawCombinedView();
         break;
@@ -81,11 +95,51 @@ void WindSpeedDisplay::draw(DrawType drawType)
 
 void WindSpeedDisplay::drawQRCode()
 {
-    M5.Lcd.qrcode(String("http://") + String("fxwind") + String(".local"), 40, 0, 240);
+    TRACE_SPAN("draw_qr_code");
+    M5.Lcd.qrcode("http://fxwind.local", 40, 0, 240);
+}
+
+// debug view with the average and longest durations in us, the sample counters and the heap
+void WindSpeedDisplay::drawMetricsView()
+{
+    TRACE_SPAN("draw_metrics");
+    _display.waitDisplay();
+    _display.setFont(&fonts::DejaVu12);
+    _display.setTextColor(TXT_DEFAULT_COLOR, TXT_DEFAULT_BACKGROUND_COLOR);
+    int yPosDelta = _display.fontHeight() + 4;
+    int yPos = PLOT_OFFSET_Y;
+
+    char text[DISPLAY_TEXT_SIZE];
+    TextFormatter formatter(text, sizeof(text));
+
+    _display.drawString("METRICS [us]     avg / max", 1, yPos);
+    for (uint8_t i = 0; i < METRICS_NUMBER_OF_TIMINGS && _metrics != nullptr; i++)
+    {
+        LatencyHistogram histogram = _metrics->getHistogram((MetricsTiming)i);
+        uint32_t average = histogram.Count > 0 ? (uint32_t)(histogram.Sum / histogram.Count) : 0;
+        formatter.clear().append(METRICS_TIMING_NAMES[i]).append(": ").appendUnsigned(average).append(" / ").appendUnsigned(histogram.Max).append("    ");
+        yPos += yPosDelta;
+        _display.drawString(text, 1, yPos);
+    }
+    SamplingStatus samplingStatus = _windSpeed->getSamplingStatus();
+    formatter.clear().append("samples: ").appendUnsigned(samplingStatus.NumberOfSamples).append(" late: ").appendUnsigned(samplingStatus.NumberOfLateSamples).append(" gaps: ").appendUnsigned(samplingStatus.NumberOfGaps).append("    ");
+    yPos += yPosDelta;
+    _display.drawString(text, 1, yPos);
+    formatter.clear().append("pulses: ").appendFixed(lroundf(_windSpeed->getPulseFrequency() * 10.0f), 1).append(" Hz glitches: ").appendUnsigned(_windSpeed->getPulseGlitchCount()).append("    ");
+    yPos += yPosDelta;
+    _display.drawString(text, 1, yPos);
+    formatter.clear().append("heap: ").appendUnsigned(ESP.getFreeHeap()).append(" block: ").appendUnsigned(ESP.getMaxAllocHeap()).append("    ");
+    yPos += yPosDelta;
+    _display.drawString(text, 1, yPos);
+    formatter.clear().append("psram: ").appendUnsigned(ESP.getPsramSize() - ESP.getFreePsram()).append(" / ").appendUnsigned(ESP.getPsramSize()).append("    ");
+    yPos += yPosDelta;
+    _display.drawString(text, 1, yPos);
+    _display.display();
 }
 
 void WindSpeedDisplay::drawStatusView()
 {
+    TRACE_SPAN("draw_status");
     _display.waitDisplay();
     drawStatus();
     _display.display();
@@ -93,6 +147,7 @@ void WindSpeedDisplay::drawStatusView()
 
 void WindSpeedDisplay::drawNumberView()
 {
+    TRACE_SPAN("draw_number");
     _display.waitDisplay();
     drawValues(_windSpeed->getCurrentWindspeed(), _windSpeed->getWindspeedEvaluation(), 0, 0);
     _display.display();
@@ -100,6 +155,7 @@ void WindSpeedDisplay::drawNumberView()
 
 void WindSpeedDisplay::drawPlotView()
 {
+    TRACE_SPAN("draw_plot");
     int evaluationBarHeight = 40;
     int plotHeight = _display.height() - evaluationBarHeight;
     _display.waitDisplay();
@@ -110,6 +166,7 @@ void WindSpeedDisplay::drawPlotView()
 
 void WindSpeedDisplay::drawCombinedView()
 {
+    TRACE_SPAN("draw_combined");
     _display.waitDisplay();
     drawValues(_windSpeed->getCurrentWindspeed(), _windSpeed->getWindspeedEvaluation(), PLOT_HEIGHT, EVALUATION_BAR_HEIGHT);
     drawBarPlot(PLOT_HEIGHT);
@@ -126,15 +183,27 @@ void WindSpeedDisplay::drawStatus()
     int spacer = 10;
     int yPosDelta = fontHeight + 4;
 
+    char text[DISPLAY_TEXT_SIZE];
+    TextFormatter formatter(text, sizeof(text));
+
     _display.drawString("STATUS DISPLAY", 1, yPos);
-    _display.drawString("Date: " + _windSpeed->getTimestampString(), 1, yPos + 1 * yPosDelta + 1 * spacer);
-    _display.drawString("Battery Level: " + String(M5.Power.getBatteryLevel()) + " %", 1, yPos + 2 * yPosDelta + 2 * spacer);
-    _display.drawString("Power connected: " + String(M5.Power.Axp192.isACIN()), 1, yPos + 3 * yPosDelta + 2 * spacer);
-    _display.drawString("Charging: " + String(M5.Power.isCharging()), 1, yPos + 4 * yPosDelta + 2 * spacer);
-    _display.drawString("Current: " + String(M5.Power.getBatteryCurrent()) + " mA", 1, yPos + 5 * yPosDelta + 2 * spacer);
-    _display.drawString("Wifi IP: " + WiFi.localIP().toString(), 1, yPos + 6 * yPosDelta + 4 * spacer);
-    _display.drawString("Wifi RSSI: " + String(WiFi.RSSI()) + " dB", 1, yPos + 7 * yPosDelta + 4 * spacer);
-    _display.drawString("FW Version: " + String(FWVERSION), 1, yPos + 8 * yPosDelta + 4 * spacer);
+    _windSpeed->formatTimestamp(formatter.clear().append("Date: "));
+    _display.drawString(text, 1, yPos + 1 * yPosDelta + 1 * spacer);
+    TelemetryData telemetryData = _telemetry != nullptr ? _telemetry->getData() : TelemetryData();
+    formatter.clear().append("Battery Level: ").appendInteger(telemetryData.BatteryLevel).append(" %");
+    _display.drawString(text, 1, yPos + 2 * yPosDelta + 2 * spacer);
+    formatter.clear().append("Power connected: ").appendInteger(telemetryData.IsPowerConnected);
+    _display.drawString(text, 1, yPos + 3 * yPosDelta + 2 * spacer);
+    formatter.clear().append("Charging: ").appendInteger(telemetryData.IsCharging);
+    _display.drawString(text, 1, yPos + 4 * yPosDelta + 2 * spacer);
+    formatter.clear().append("Current: ").appendInteger(telemetryData.BatteryCurrent).append(" mA");
+    _display.drawString(text, 1, yPos + 5 * yPosDelta + 2 * spacer);
+    IPAddress ipAddress = WiFi.localIP();
+    formatter.clear().append("Wifi IP: ").appendUnsigned(ipAddress[0]).append('.').appendUnsigned(ipAddress[1]).append('.').appendUnsigned(ipAddress[2]).append('.').appendUnsigned(ipAddress[3]);
+    _display.drawString(text, 1, yPos + 6 * yPosDelta + 4 * spacer);
+    formatter.clear().append("Wifi RSSI: ").appendInteger(telemetryData.WifiRSSI).append(" dB");
+    _display.drawString(text, 1, yPos + 7 * yPosDelta + 4 * spacer);
+    _display.drawString("FW Version: " FWVERSION, 1, yPos + 8 * yPosDelta + 4 * spacer);
   }
 
 void WindSpeedDisplay::drawValues(float windspeed, WindspeedEvaluation windspeedEvaluation, int plotHeight, int evaluationBarHeight)
@@ -155,11 +224,36 @@ void WindSpeedDisplay::drawValues(float windspeed, WindspeedEvaluation windspeed
     {
         _display.setTextColor(TXT_DEFAULT_COLOR, TXT_DEFAULT_BACKGROUND_COLOR);
     }
-    _display.drawString(_windSpeed->getWindspeedString(true), 1, yPos);
+    char text[DISPLAY_TEXT_SIZE];
+    TextFormatter formatter(text, sizeof(text));
+    _windSpeed->formatWindspeed(formatter, true);
+    _display.drawString(text, 1, yPos);
+#if DISPLAY_TREND_INDICATOR
+    drawTrendIndicator(windspeedEvaluation, yPos, bigFontHeight);
+#endif
     _display.setFont(&fonts::DejaVu18);
     _display.setTextColor(TXT_DEFAULT_COLOR, TXT_DEFAULT_BACKGROUND_COLOR);
-    String evaluationString = _windSpeed->getWindspeedEvaluationString();
-    _display.drawString(evaluationString, 24, yPos + bigFontHeight + 6);
+    _windSpeed->formatWindspeedEvaluation(formatter.clear());
+    _display.drawString(text, 24, yPos + bigFontHeight + 6);
+}
+
+// arrow towards the threshold which is expected to be crossed within TREND_WARNING_TIME
+void WindSpeedDisplay::drawTrendIndicator(WindspeedEvaluation windspeedEvaluation, int yPos, int height)
+{
+    int x = _display.width() - TREND_INDICATOR_SIZE - 4;
+    int y = yPos + (height - TREND_INDICATOR_SIZE) / 2;
+    _display.fillRect(x, y, TREND_INDICATOR_SIZE, TREND_INDICATOR_SIZE, TXT_DEFAULT_BACKGROUND_COLOR);
+
+    float timeToUpperThreshold = windspeedEvaluation.TimeToUpperThreshold;
+    float timeToLowerThreshold = windspeedEvaluation.TimeToLowerThreshold;
+    if (timeToUpperThreshold > 0.0f && timeToUpperThreshold <= TREND_WARNING_TIME)
+    {
+        _display.fillTriangle(x, y + TREND_INDICATOR_SIZE - 1, x + TREND_INDICATOR_SIZE - 1, y + TREND_INDICATOR_SIZE - 1, x + TREND_INDICATOR_SIZE / 2, y, TREND_INDICATOR_COLOR);
+    }
+    else if (timeToLowerThreshold > 0.0f && timeToLowerThreshold <= TREND_WARNING_TIME)
+    {
+        _display.fillTriangle(x, y, x + TREND_INDICATOR_SIZE - 1, y, x + TREND_INDICATOR_SIZE / 2, y + TREND_INDICATOR_SIZE - 1, TREND_INDICATOR_COLOR);
+    }
 }
 
 void WindSpeedDisplay::drawGrid(int plotHeight)
@@ -168,10 +262,13 @@ void WindSpeedDisplay::drawGrid(int plotHeight)
     _display.setTextColor(TXT_DEFAULT_COLOR, TXT_DEFAULT_BACKGROUND_COLOR);
     int fontOffsetY = (int)(_display.fontHeight() / 2.0f);
     int scaleTicks = (int)(plotHeight / 10.0);
+    char text[4];
+    TextFormatter formatter(text, sizeof(text));
     for (size_t i = 0; i <= 10; i += 2)
     {
+        formatter.clear().appendUnsigned(i);
         int fontOffsetX = i < 10 ? _display.fontWidth() : 2 * _display.fontWidth();
-        _display.drawString(String(i), PLOT_OFFSET_X - fontOffsetX - 10, PLOT_OFFSET_Y - fontOffsetY + plotHeight - i * scaleTicks);
+        _display.drawString(text, PLOT_OFFSET_X - fontOffsetX - 10, PLOT_OFFSET_Y - fontOffsetY + plotHeight - i * scaleTicks);
     }
 
     for (size_t i = 0; i <= 10; i += 1)
@@ -214,10 +311,13 @@ void WindSpeedDisplay::drawEvaluationBars(WindspeedEvaluation windspeedEvaluatio
     int y = PLOT_OFFSET_Y + plotHeight + 3;
     _display.fillRect(PLOT_OFFSET_X - 1, y, _evaluationRange, evaluationBarHeight, TFT_GREEN);
     int numberTextXOffset = (int) (_windspeedDurationRange - 10)/2 + 1;
+    char text[4];
+    TextFormatter formatter(text, sizeof(text));
     for (size_t i = 0; i < windspeedEvaluation.NumberOfExceededRanges; i++)
     {
         int x = PLOT_OFFSET_X + _evaluationRange - windspeedEvaluation.RangeStartIndex[i] - _windspeedDurationRange;
         _display.fillRect(x, y, _windspeedDurationRange, evaluationBarHeight, TFT_RED);
-        _display.drawString(String(i + 1), x + numberTextXOffset, y + evaluationBarHeight / 5);
+        formatter.clear().appendUnsigned(i + 1);
+        _display.drawString(text, x + numberTextXOffset, y + evaluationBarHeight / 5);
     }
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 
 #include "Arduino.h"
 #include "WindSpeed.h"
+#include "Telemetry.h"
+#include "Metrics.h"
+#include "Tracer.h"
 #include <M5GFX.h>
 #include <M5Unified.h>
 #include <WiFiManager.h>
@@ -13,7 +16,8 @@ enum struct DrawType
     PLOT = 1,
     NUMBER = 2,
     STATUS = 3,
-    QR_CODE = 4
+    QR_CODE = 4,
+    METRICS = 5
 };
 
 #define PLOT_OFFSET_X 20
@@ -27,6 +31,16 @@ enum struct DrawType
 #define GRID_COLOR TFT_DARKGREY
 #define PLOT_BAR_DEFAULT_COLOR TFT_GREEN
 #define PLOT_BAR_ALERT_COLOR TFT_RED
+#define DISPLAY_TEXT_SIZE 48
+#define TREND_INDICATOR_COLOR TFT_ORANGE
+#define TREND_INDICATOR_SIZE 24
+#define TREND_WARNING_TIME 60 // s, predicted threshold crossings within this time are indicated
+
+// trend indicator next to the current windspeed, could be disabled with a build flag
+#ifndef DISPLAY_TREND_INDICATOR
+#define DISPLAY_TREND_INDICATOR 1
+#endif
+
 class WindSpeedDisplay
 {
 
@@ -35,6 +49,8 @@ public:
     void setup();
     void updateSettings(uint16_t lowerWindspeedThreshold, uint16_t upperWindspeedThreshold, uint16_t evaluationRange, uint16_t windspeedDurationRange, int brightness);
     void draw(DrawType drawType);
+    void setupTelemetry(Telemetry *telemetry);
+    void setupMetrics(Metrics *metrics);
 
 private:
     M5GFX _display;
@@ -43,6 +59,8 @@ private:
     uint16_t _upperWindspeedThreshold = 8;
     uint16_t _windspeedDurationRange = 20;
     WindSpeed *_windSpeed;
+    Telemetry *_telemetry = nullptr;
+    Metrics *_metrics = nullptr;
     DrawType _currentDrawType;
 
     void drawStatusView();
@@ -50,9 +68,11 @@ private:
     void drawCombinedView();
     void drawNumberView();
     void drawQRCode();
+    void drawMetricsView();
 
     void drawStatus();
     void drawValues(float windspeed, WindspeedEvaluation windspeedEvaluation, int plotHeight, int evaluationBarHeight);
+    void drawTrendIndicator(WindspeedEvaluation windspeedEvaluation, int yPos, int height);
     void drawBarPlot(int plotHeight);
     void drawEvaluationBars(WindspeedEvaluation windspeedEvaluation, int plotHeight, int evaluationBarHeight);
     void drawGrid(int plotHeight);
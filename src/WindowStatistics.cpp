@@ -0,0 +1,190 @@
+#include "WindowStatistics.h"
+
+WindowStatistics::WindowStatistics()
+{
+}
+
+WindowStatistics::~WindowStatistics()
+{
+    release();
+}
+
+void WindowStatistics::release()
+{
+    delete[] _values;
+    delete[] _gusts;
+    delete[] _queueBuffer;
+    _values = nullptr;
+    _gusts = nullptr;
+    _queueBuffer = nullptr;
+    _capacity = 0;
+    _numberOfWindows = 0;
+}
+
+// window lengths in samples, the sample ring is sized for the longest window
+bool WindowStatistics::setupWindows(const uint16_t *lengths, uint8_t numberOfWindows)
+{
+    release();
+    if (numberOfWindows > STATISTICS_MAX_WINDOWS)
+    {
+        return false;
+    }
+
+    size_t queueLength = 0;
+    for (size_t i = 0; i < numberOfWindows; i++)
+    {
+        if (lengths[i] == 0)
+        {
+            return false;
+        }
+        if (lengths[i] > _capacity)
+        {
+            _capacity = lengths[i];
+        }
+        queueLength += 3 * lengths[i];
+    }
+    if (numberOfWindows == 0)
+    {
+        return true;
+    }
+
+    _values = new int16_t[_capacity];
+    _gusts = new int16_t[_capacity];
+    _queueBuffer = new uint16_t[queueLength];
+
+    uint16_t *queueBuffer = _queueBuffer;
+    for (size_t i = 0; i < numberOfWindows; i++)
+    {
+        StatisticsWindow &window = _windows[i];
+        window.Length = lengths[i];
+        MonotonicQueue *queues[] = {&window.MinQueue, &window.MaxQueue, &window.GustQueue};
+        for (MonotonicQueue *queue : queues)
+        {
+            queue->Indices = queueBuffer;
+            queue->Capacity = window.Length;
+            queueBuffer += window.Length;
+        }
+    }
+    _numberOfWindows = numberOfWindows;
+    reset();
+    return true;
+}
+
+void WindowStatistics::reset()
+{
+    _index = 0;
+    for (size_t i = 0; i < _numberOfWindows; i++)
+    {
+        StatisticsWindow &window = _windows[i];
+        window.NumberOfSamples = 0;
+        window.Sum = 0;
+        window.MinQueue.Head = window.MinQueue.Size = 0;
+        window.MaxQueue.Head = window.MaxQueue.Size = 0;
+        window.GustQueue.Head = window.GustQueue.Size = 0;
+    }
+}
+
+void WindowStatistics::push(int16_t value, int16_t gust)
+{
+    if (_numberOfWindows == 0)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < _numberOfWindows; i++)
+    {
+        StatisticsWindow &window = _windows[i];
+        if (window.NumberOfSamples == window.Length)
+        {
+            // sample leaving the window, pushed Length samples ago
+            uint16_t evictedIndex = (_index + _capacity - window.Length) % _capacity;
+            window.Sum -= _values[evictedIndex];
+            evict(window.MinQueue, evictedIndex);
+            evict(window.MaxQueue, evictedIndex);
+            evict(window.GustQueue, evictedIndex);
+        }
+        else
+        {
+            window.NumberOfSamples++;
+        }
+    }
+
+    _values[_index] = value;
+    _gusts[_index] = gust;
+
+    for (size_t i = 0; i < _numberOfWindows; i++)
+    {
+        StatisticsWindow &window = _windows[i];
+        window.Sum += value;
+        pushMin(window.MinQueue, _values, _index);
+        pushMax(window.MaxQueue, _values, _index);
+        pushMax(window.GustQueue, _gusts, _index);
+    }
+
+    _index = (_index + 1) % _capacity;
+}
+
+uint8_t WindowStatistics::getNumberOfWindows()
+{
+    return _numberOfWindows;
+}
+
+WindowStatisticsResult WindowStatistics::getResult(uint8_t window)
+{
+    WindowStatisticsResult result = {0, 0, 0, 0, 0, 0};
+    if (window >= _numberOfWindows)
+    {
+        return result;
+    }
+    StatisticsWindow &statisticsWindow = _windows[window];
+    result.Length = statisticsWindow.Length;
+    result.NumberOfSamples = statisticsWindow.NumberOfSamples;
+    result.Sum = statisticsWindow.Sum;
+    if (statisticsWindow.NumberOfSamples > 0)
+    {
+        result.Min = _values[front(statisticsWindow.MinQueue)];
+        result.Max = _values[front(statisticsWindow.MaxQueue)];
+        result.Gust = _gusts[front(statisticsWindow.GustQueue)];
+    }
+    return result;
+}
+
+void WindowStatistics::pushMin(MonotonicQueue &queue, const int16_t *values, uint16_t index)
+{
+    while (queue.Size > 0 && values[back(queue)] >= values[index])
+    {
+        queue.Size--;
+    }
+    queue.Indices[(queue.Head + queue.Size) % queue.Capacity] = index;
+    queue.Size++;
+}
+
+void WindowStatistics::pushMax(MonotonicQueue &queue, const int16_t *values, uint16_t index)
+{
+    while (queue.Size > 0 && values[back(queue)] <= values[index])
+    {
+        queue.Size--;
+    }
+    queue.Indices[(queue.Head + queue.Size) % queue.Capacity] = index;
+    queue.Size++;
+}
+
+// indices inside the window are unique, so the front is only removed if it leaves the window
+void WindowStatistics::evict(MonotonicQueue &queue, uint16_t index)
+{
+    if (queue.Size > 0 && front(queue) == index)
+    {
+        queue.Head = (queue.Head + 1) % queue.Capacity;
+        queue.Size--;
+    }
+}
+
+uint16_t WindowStatistics::front(MonotonicQueue &queue)
+{
+    return queue.Indices[queue.Head];
+}
+
+uint16_t WindowStatistics::back(MonotonicQueue &queue)
+{
+    return queue.Indices[(queue.Head + queue.Size - 1) % queue.Capacity];
+}
@@ -0,0 +1,69 @@
+#ifndef WindowStatistics_h
+#define WindowStatistics_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define STATISTICS_MAX_WINDOWS 8
+
+// statistics of one window in the units of the pushed samples
+struct WindowStatisticsResult
+{
+    uint16_t Length;
+    uint16_t NumberOfSamples;
+    int32_t Sum;
+    int16_t Min;
+    int16_t Max;
+    int16_t Gust;
+};
+
+// ring of sample indices with monotonic values, front is the min/max of the window
+struct MonotonicQueue
+{
+    uint16_t *Indices;
+    uint16_t Capacity;
+    uint16_t Head;
+    uint16_t Size;
+};
+
+struct StatisticsWindow
+{
+    uint16_t Length;
+    uint16_t NumberOfSamples;
+    int32_t Sum;
+    MonotonicQueue MinQueue;
+    MonotonicQueue MaxQueue;
+    MonotonicQueue GustQueue;
+};
+
+// maintains running sum, min, max and gust of any number of windows over the same sample
+// stream. All windows share one sample ring, every push is amortized O(1) per window and
+// all memory is allocated once in setupWindows.
+class WindowStatistics
+{
+public:
+    WindowStatistics();
+    ~WindowStatistics();
+    bool setupWindows(const uint16_t *lengths, uint8_t numberOfWindows);
+    void reset();
+    void push(int16_t value, int16_t gust);
+    uint8_t getNumberOfWindows();
+    WindowStatisticsResult getResult(uint8_t window);
+
+private:
+    StatisticsWindow _windows[STATISTICS_MAX_WINDOWS];
+    uint8_t _numberOfWindows = 0;
+    int16_t *_values = nullptr;
+    int16_t *_gusts = nullptr;
+    uint16_t *_queueBuffer = nullptr;
+    uint16_t _capacity = 0;
+    uint16_t _index = 0;
+    void release();
+    void pushMin(MonotonicQueue &queue, const int16_t *values, uint16_t index);
+    void pushMax(MonotonicQueue &queue, const int16_t *values, uint16_t index);
+    void evict(MonotonicQueue &queue, uint16_t index);
+    uint16_t front(MonotonicQueue &queue);
+    uint16_t back(MonotonicQueue &queue);
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "WindspeedHistogram.h"
+
+WindspeedHistogram::WindspeedHistogram()
+{
+    static_assert(WindSpeedConfig::MAX_EVALUATION_RANGE <= UINT16_MAX, "histogram bins could overflow");
+    reset();
+}
+
+void WindspeedHistogram::reset()
+{
+    for (size_t i = 0; i < HISTOGRAM_NUMBER_OF_BINS; i++)
+    {
+        _bins[i] = 0;
+    }
+    _numberOfSamples = 0;
+}
+
+uint16_t WindspeedHistogram::toBin(int16_t value)
+{
+    if (value < 0)
+    {
+        return 0;
+    }
+    if (value >= HISTOGRAM_NUMBER_OF_BINS)
+    {
+        return HISTOGRAM_NUMBER_OF_BINS - 1;
+    }
+    return value;
+}
+
+void WindspeedHistogram::push(int16_t value)
+{
+    _bins[toBin(value)]++;
+    _numberOfSamples++;
+}
+
+void WindspeedHistogram::evict(int16_t value)
+{
+    uint16_t bin = toBin(value);
+    if (_bins[bin] == 0)
+    {
+        return;
+    }
+    _bins[bin]--;
+    _numberOfSamples--;
+}
+
+uint32_t WindspeedHistogram::getNumberOfSamples()
+{
+    return _numberOfSamples;
+}
+
+uint16_t WindspeedHistogram::getCount(uint16_t bin)
+{
+    return bin < HISTOGRAM_NUMBER_OF_BINS ? _bins[bin] : 0;
+}
+
+uint16_t WindspeedHistogram::getHighestBin()
+{
+    for (size_t i = HISTOGRAM_NUMBER_OF_BINS; i > 0; --i)
+    {
+        if (_bins[i - 1] > 0)
+        {
+            return i - 1;
+        }
+    }
+    return 0;
+}
+
+// nearest rank percentile in storage units
+int16_t WindspeedHistogram::getPercentile(uint8_t percent)
+{
+    if (_numberOfSamples == 0)
+    {
+        return 0;
+    }
+    uint32_t rank = ((uint32_t)percent * _numberOfSamples + 99) / 100;
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    uint32_t cumulatedCount = 0;
+    for (size_t i = 0; i < HISTOGRAM_NUMBER_OF_BINS; i++)
+    {
+        cumulatedCount += _bins[i];
+        if (cumulatedCount >= rank)
+        {
+            return i;
+        }
+    }
+    return HISTOGRAM_NUMBER_OF_BINS - 1;
+}
+
+uint32_t WindspeedHistogram::getNumberOfSamplesAbove(int16_t value)
+{
+    uint32_t count = 0;
+    for (size_t i = toBin(value) + 1; i < HISTOGRAM_NUMBER_OF_BINS; i++)
+    {
+        count += _bins[i];
+    }
+    return value < 0 ? _numberOfSamples : count;
+}
+
+uint32_t WindspeedHistogram::getNumberOfSamplesBelow(int16_t value)
+{
+    uint32_t count = 0;
+    for (size_t i = 0; i < toBin(value); i++)
+    {
+        count += _bins[i];
+    }
+    return count;
+}
@@ -0,0 +1,33 @@
+#ifndef WindspeedHistogram_h
+#define WindspeedHistogram_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include "WindSpeedConfig.h"
+
+// one bin per storage unit (0.1 m/s), values above the last bin are counted in the last bin
+#define HISTOGRAM_NUMBER_OF_BINS (WindSpeedConfig::MAX_WINDSPEED * WindSpeedConfig::STORAGE_SCALE + 1)
+
+// fixed bin histogram of the samples inside the evaluation window, updated incrementally
+// when a sample enters or leaves the window. Memory does not depend on the window length.
+class WindspeedHistogram
+{
+public:
+    WindspeedHistogram();
+    void reset();
+    void push(int16_t value);
+    void evict(int16_t value);
+    uint32_t getNumberOfSamples();
+    uint16_t getCount(uint16_t bin);
+    uint16_t getHighestBin();
+    int16_t getPercentile(uint8_t percent);
+    uint32_t getNumberOfSamplesAbove(int16_t value);
+    uint32_t getNumberOfSamplesBelow(int16_t value);
+
+private:
+    uint16_t _bins[HISTOGRAM_NUMBER_OF_BINS];
+    uint32_t _numberOfSamples = 0;
+    uint16_t toBin(int16_t value);
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "WindspeedTrend.h"
+
+WindspeedTrend::WindspeedTrend()
+{
+    reset();
+}
+
+void WindspeedTrend::reset()
+{
+    _smoothed = 0;
+    _sum = 0;
+    _weightedSum = 0;
+    _numberOfSamples = 0;
+}
+
+// evictedValue is the sample TREND_SLOPE_RANGE samples before value, ignored until the window is full
+void WindspeedTrend::push(int16_t value, int16_t evictedValue)
+{
+    // smoothed value is kept with 8 fractional bits
+    int32_t scaledValue = (int32_t)value * 256;
+    if (_numberOfSamples == 0)
+    {
+        _smoothed = scaledValue;
+    }
+    else
+    {
+        _smoothed += (scaledValue - _smoothed) / (1 << TREND_SMOOTHING_SHIFT);
+    }
+
+    // sample x = 0 is the oldest one, sliding the window shifts all x by one
+    if (_numberOfSamples < TREND_SLOPE_RANGE)
+    {
+        _weightedSum += (int64_t)_numberOfSamples * value;
+        _sum += value;
+        _numberOfSamples++;
+    }
+    else
+    {
+        _weightedSum += -_sum + evictedValue + (int64_t)(TREND_SLOPE_RANGE - 1) * value;
+        _sum += value - evictedValue;
+    }
+}
+
+float WindspeedTrend::getSmoothed()
+{
+    return _smoothed / 256.0f;
+}
+
+// least squares slope in sample units per sample
+float WindspeedTrend::getSlope()
+{
+    int64_t n = _numberOfSamples;
+    if (n < 2)
+    {
+        return 0.0f;
+    }
+    // sum of x = n(n-1)/2, n * sum of x^2 - (sum of x)^2 = n^2(n^2-1)/12
+    int64_t numerator = 12 * (n * _weightedSum - n * (n - 1) / 2 * _sum);
+    int64_t denominator = n * n * (n * n - 1);
+    return (float)numerator / (float)denominator;
+}
+
+// samples until the smoothed value reaches the threshold with the current slope, 0 if it is
+// already beyond the threshold and negative if no crossing is expected within TREND_MAX_PREDICTION
+float WindspeedTrend::getSamplesToCrossing(int16_t threshold, bool isUpperThreshold)
+{
+    if (_numberOfSamples == 0)
+    {
+        return -1.0f;
+    }
+    float distance = threshold - getSmoothed();
+    if (isUpperThreshold ? distance < 0.0f : distance > 0.0f)
+    {
+        return 0.0f;
+    }
+    float slope = getSlope();
+    if (isUpperThreshold ? slope <= 0.0f : slope >= 0.0f)
+    {
+        return -1.0f;
+    }
+    float samples = distance / slope;
+    return samples <= TREND_MAX_PREDICTION ? samples : -1.0f;
+}
@@ -0,0 +1,31 @@
+#ifndef WindspeedTrend_h
+#define WindspeedTrend_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TREND_SMOOTHING_SHIFT 3     // exponential smoothing factor 1/2^shift
+#define TREND_SLOPE_RANGE 30        // samples of the least squares slope
+#define TREND_MAX_PREDICTION 600    // samples, farther crossings are not predicted
+
+// running exponential smoothing and sliding window least squares slope of the sample
+// stream, both updated in O(1) per sample. The sample leaving the slope window is
+// passed in by the caller, so no additional sample buffer is needed.
+class WindspeedTrend
+{
+public:
+    WindspeedTrend();
+    void reset();
+    void push(int16_t value, int16_t evictedValue);
+    float getSmoothed();
+    float getSlope();
+    float getSamplesToCrossing(int16_t threshold, bool isUpperThreshold);
+
+private:
+    int32_t _smoothed = 0;
+    int64_t _sum = 0;
+    int64_t _weightedSum = 0;
+    uint16_t _numberOfSamples = 0;
+};
+
+#endif
@@ -9,40 +9,74 @@
 #include <ArduinoJson.h>
 #include <LittleFS.h>
 #include "WindSpeed.h"
+#include "TimeSync.h"
+#include "SoundSequencer.h"
+#include "Telemetry.h"
+#include "SpiBus.h"
+#include "FileDownload.h"
+#include "AdmissionControl.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include "JsonArena.h"
+#include "BootProfiler.h"
+#include "SnapshotRenderer.h"
+#include "PcntPulseSource.h"
 #include "WindSpeedDisplay.h"
 #include "StartupDisplay.h"
 #include <Preferences.h>
+#include "Settings.h"
+#include "SettingsStore.h"
 #include "WifiConfigDisplay.h"
 #include <ESPAsyncHTTPUpdateServer.h>
 
 // constants
 #define WINDSPEED_PIN 19
 #define WINDSPEED_EVALUATION_RANGE 300
-#define SAMPLE_RATE 1000            // ms
+#define SAMPLE_RATE WindSpeedConfig::SAMPLE_PERIOD // ms
 #define WINDSPEED_LOWER_THRESHOLD 0 // m/s
 #define WINDSPEED_UPPER_THRESHOLD 8       // m/s
 #define WINDSPEED_DURATION_RANGE 20 // samples
 #define WINDSPEED_NUMBER_OF_WINDOWS 3
-#define TIME_SYNC_INTERVAL 600
+#define TIME_SYNC_INTERVAL 600 // s, sntp poll interval
+#define SYSTEM_TIME_SYNC_INTERVAL 10 // s, TimeLib reads the system time
+#define STATISTICS_WINDOWS {120, 300, 600} // samples, 2min mean, FAI evaluation range, 10min mean
 #define VOLUME 100            // %
 #define DISPLAY_BRIGHTNESS 50 // %
 #define CHARGE_CURRENT 800    // mA
 #define PREFERENCE_NAMESPACE "fxwind"
+#define CALIBRATION_PREFERENCE_KEY "CalibPoints"
+#define CALIBRATION_MAX_BODY_SIZE 2048 // bytes of a calibration request, 16 points with whitespace
+#define ALARM_RULES_PREFERENCE_KEY "AlarmRules"
+#define ALARM_RULES_MAX_BODY_SIZE 4096 // bytes of an alarm rules request, 8 rules with whitespace
+#define SETTINGS_PREFERENCE_KEY "Settings"
+#define SETTINGS_VERSION 1 // has to be increased with every change of the settings struct
 #define MDNSNAME "fxwind"
 #define AP_SSID "fxwind Accesspoint"
+#define LAST_DRAW_TYPE DrawType::METRICS // the views are swiped through up to this one
+#define BOOT_TASK_STACK_SIZE 8192
+#define ADMISSION_CLASS_LIMITS {{8, 1}, {3, 5}} // concurrent requests and retry after in s of the cheap and expensive requests
+#define LIVE_REQUEST_LIMITS 4, 10, 100 // concurrent requests, budget, ms until the budget grows by one
+#define CONFIGURATION_REQUEST_LIMITS 2, 5, 500
+#define PAGE_REQUEST_LIMITS 2, 4, 1000
+#define DOWNLOAD_REQUEST_LIMITS 2, 4, 2000
+#define WRITE_REQUEST_LIMITS 1, 3, 2000  // settings, calibration, alarms and wifi reset are written one at a time
+#define UPDATE_REQUEST_LIMITS 1, 1, 60000
+#define BOOT_TASK_PRIORITY 1
 
 // structs, enums
-struct Settings
-{
-  int Volume;
-  int CalibrationFactor;
-  int LowerWindspeedThreshold;
-  int UpperWindspeedThreshold;
-  int WindspeedEvaluationRange;
-  int WindspeedDurationRange;
-  int WindspeedNumberOfWindows;
-  int DisplayBrightness;
-  int MaximumChargeCurrent;
+struct BootTask
+{
+  const char *Name;
+  void (*Function)();
+};
+
+// collected body of a request which is applied as a whole, the received bytes follow the struct
+struct RequestBody
+{
+  size_t Length;
+  bool IsApplied;
+  const char *Error; // why the body was not applied, nullptr if it is incomplete
+  const char *Field;
 };
 
 // global variables
@@ -50,134 +84,82 @@ Preferences preferences;
 WiFiManager wifiManager;
 M5GFX display;
 Settings settings = {VOLUME, 1, WINDSPEED_LOWER_THRESHOLD, WINDSPEED_UPPER_THRESHOLD, WINDSPEED_EVALUATION_RANGE, WINDSPEED_DURATION_RANGE, WINDSPEED_NUMBER_OF_WINDOWS, DISPLAY_BRIGHTNESS, CHARGE_CURRENT};
+SettingsStore settingsStore(PREFERENCE_NAMESPACE, SETTINGS_PREFERENCE_KEY, SETTINGS_VERSION, &settings, sizeof(settings));
 WindSpeed windSpeed(WINDSPEED_PIN, settings.LowerWindspeedThreshold, settings.UpperWindspeedThreshold, settings.WindspeedDurationRange, settings.WindspeedEvaluationRange, settings.WindspeedNumberOfWindows, settings.CalibrationFactor);
+#ifdef WINDSPEED_PULSE_SOURCE_PCNT
+PcntPulseSource pcntPulseSource(WINDSPEED_PIN);
+#endif
 WindSpeedDisplay windSpeedDisplay(settings.LowerWindspeedThreshold, settings.UpperWindspeedThreshold, settings.WindspeedEvaluationRange, settings.WindspeedDurationRange, &windSpeed);
 StartupDisplay startupDisplay;
 WifiConfigDisplay wifiConfigDisplay;
 
-WiFiUDP Udp;
+TimeSync timeSync;
+BootProfiler bootProfiler;
+SoundSequencer soundSequencer;
+Telemetry telemetry;
+SpiBus spiBus;
+static const AdmissionClassLimits admissionClassLimits[] = ADMISSION_CLASS_LIMITS;
+AdmissionControl admissionControl(admissionClassLimits);
+Metrics metrics;
 ESPAsyncHTTPUpdateServer updateServer;
 AsyncWebServer server(80);
+AsyncEventSource events("/events");
 unsigned long lastMillis;
 static const char *hostname = "f3xwind";
 static const char ntpServerName[] = "de.pool.ntp.org";
-unsigned int localPort = 8888;
-const int timeZone = 0;
-const int NTP_PACKET_SIZE = 48;
-byte packetBuffer[NTP_PACKET_SIZE];
 int menuX = 0;
 bool isAlarmActive = false;
 bool isStartupActive = true;
 bool isAPModeActive = true;
 bool isWifiOn = false;
+bool isDisplayReady = false;
+bool isFirstSample = true;
+volatile bool isWifiConfigActive = false;
+volatile bool isWifiConfigFinished = false;
 int touchDuration = 0;
 bool isSwitchoffSoundActive = false;
+Settings pendingSettings; // patched copy of the settings, applied by the loop
+uint8_t pendingSettingsSubsystems = 0; // subsystems changed by the pending settings
+portMUX_TYPE pendingSettingsLock = portMUX_INITIALIZER_UNLOCKED;
 
+static const uint16_t statisticsWindows[] = STATISTICS_WINDOWS;
 static constexpr const char *menu_x_items[4] = {"Combined", "Plot", "Number", "Stats"};
 
-void saveSettings();
-
-void interruptCallback(void)
-{
-  windSpeed.interruptCallback();
-}
-
-// send an NTP request to the time server at the given address
-void sendNTPpacket(IPAddress &address)
-{
-  // set all bytes in the buffer to 0
-  memset(packetBuffer, 0, NTP_PACKET_SIZE);
-  // Initialize values needed to form NTP request
-  // (see URL above for details on the packets)
-  packetBuffer[0] = 0b11100011; // LI, Version, Mode
-  packetBuffer[1] = 0;          // Stratum, or type of clock
-  packetBuffer[2] = 6;          // Polling Interval
-  packetBuffer[3] = 0xEC;       // Peer Clock Precision
-  // 8 bytes of zero for Root Delay & Root Dispersion
-  packetBuffer[12] = 49;
-  packetBuffer[13] = 0x4E;
-  packetBuffer[14] = 49;
-  packetBuffer[15] = 52;
-  // all NTP fields have been given values, now
-  // you can send a packet requesting a timestamp:
-  Udp.beginPacket(address, 123); // NTP requests are to port 123
-  Udp.write(packetBuffer, NTP_PACKET_SIZE);
-  Udp.endPacket();
-}
-
-time_t getRtcTime()
-{
-  // Get the current RTC datetime
-  auto dateTime = M5.Rtc.getDateTime();
-
-  // Populate the tm structure
-  struct tm t;
-  t.tm_year = dateTime.date.year - 1900; // tm_year is years since 1900
-  t.tm_mon = dateTime.date.month - 1;    // tm_mon is 0-based (0 = January)
-  t.tm_mday = dateTime.date.date;
-  t.tm_hour = dateTime.time.hours;
-  t.tm_min = dateTime.time.minutes;
-  t.tm_sec = dateTime.time.seconds;
-  t.tm_isdst = -1; // Daylight saving time (let the system determine)
-
-  // Convert to time_t
-  Serial.println("time synched from RTC");
-  return mktime(&t);
-}
-
-time_t getNtpTime()
-{
-  IPAddress ntpServerIP;
-
-  while (Udp.parsePacket() > 0)
-    ; // discard any previously received packets
-  Serial.println("Transmit NTP Request");
-  // get a random server from the pool
-  WiFi.hostByName(ntpServerName, ntpServerIP);
-  Serial.print(ntpServerName);
-  Serial.print(": ");
-  Serial.println(ntpServerIP);
-  sendNTPpacket(ntpServerIP);
-  uint32_t beginWait = millis();
-  while (millis() - beginWait < 1500)
-  {
-    int size = Udp.parsePacket();
-    if (size >= NTP_PACKET_SIZE)
-    {
-      Serial.println("Receive NTP Response");
-      Udp.read(packetBuffer, NTP_PACKET_SIZE); // read packet into the buffer
-      unsigned long secsSince1900;
-      // convert four bytes starting at location 40 to a long integer
-      secsSince1900 = (unsigned long)packetBuffer[40] << 24;
-      secsSince1900 |= (unsigned long)packetBuffer[41] << 16;
-      secsSince1900 |= (unsigned long)packetBuffer[42] << 8;
-      secsSince1900 |= (unsigned long)packetBuffer[43];
-      unsigned long timeValue = secsSince1900 - 2208988800UL + timeZone * SECS_PER_HOUR;
-      Serial.println("time synched from NTP server");
-      return timeValue;
-    }
-  }
-  Serial.println("No NTP Response :-(");
-  return 0; // return 0 if unable to get the time
+// the sd card is accessed in short slices of the shared spi bus, one directory entry per slice
+File openSDFile(const String &path)
+{
+  TRACE_SPAN("sd_open");
+  SpiBusLock lock(&spiBus, SpiBusPriority::DOWNLOAD, FILE_DOWNLOAD_OPEN_TIMEOUT);
+  return lock.isAcquired() ? SD.open(path) : File();
 }
 
-String getDownloadFilesJson()
+File openNextSDFile(File &directory)
 {
+  TRACE_SPAN("sd_next_file");
+  SpiBusLock lock(&spiBus, SpiBusPriority::DOWNLOAD, FILE_DOWNLOAD_OPEN_TIMEOUT);
+  return lock.isAcquired() ? directory.openNextFile() : File();
+}
 
-  JsonDocument jsonDocument;
+bool existsSDFile(const String &path)
+{
+  SpiBusLock lock(&spiBus, SpiBusPriority::DOWNLOAD, FILE_DOWNLOAD_OPEN_TIMEOUT);
+  return lock.isAcquired() && SD.exists(path);
+}
 
-  File logDirectory = SD.open("/logs");
+void addDownloadFilesJson(JsonDocument &jsonDocument)
+{
+  File logDirectory = openSDFile("/logs");
 
   if (!logDirectory)
   {
-    return String();
+    return;
   }
   if (!logDirectory.isDirectory())
   {
-    return String();
+    return;
   }
 
-  File file = logDirectory.openNextFile();
+  File file = openNextSDFile(logDirectory);
 
   while (file)
   {
@@ -194,22 +176,34 @@ String getDownloadFilesJson()
       else
         fsize = String(bytes / 1024.0 / 1024.0 / 1024.0, 3) + " GB";
 
-      JsonObject arrayDocument = jsonDocument.add<JsonObject>();
-      arrayDocument["Date"] = String(file.name()).substring(0, 10);
-      arrayDocument["Filename"] = String(file.name());
-      arrayDocument["Filesize"] = fsize;
-      arrayDocument["DownloadUrl"] = "/downloads?filename=" + String(file.name());
+      // binary snapshots are listed with the formats they are rendered to on download, without a size
+      // because the size of a rendered file is only known after rendering
+      String filename = String(file.name());
+      if (filename.endsWith(SNAPSHOT_FILE_EXTENSION))
+      {
+        for (size_t i = 0; i < sizeof(SNAPSHOT_FORMAT_SUFFIXES) / sizeof(SNAPSHOT_FORMAT_SUFFIXES[0]); i++)
+        {
+          String renderedFilename = SnapshotRenderer::getRenderedFilePath(filename, (SnapshotFormat)i);
+          JsonObject arrayDocument = jsonDocument.add<JsonObject>();
+          arrayDocument["Date"] = renderedFilename.substring(0, 10);
+          arrayDocument["Filename"] = renderedFilename;
+          arrayDocument["DownloadUrl"] = "/downloads?filename=" + renderedFilename;
+        }
+      }
+      else
+      {
+        JsonObject arrayDocument = jsonDocument.add<JsonObject>();
+        arrayDocument["Date"] = filename.substring(0, 10);
+        arrayDocument["Filename"] = filename;
+        arrayDocument["Filesize"] = fsize;
+        arrayDocument["DownloadUrl"] = "/downloads?filename=" + filename;
+      }
     }
     file.close();
-    file = logDirectory.openNextFile();
+    file = openNextSDFile(logDirectory);
   }
 
   file.close();
-  String jsonString;
-  jsonDocument.shrinkToFit();
-  serializeJson(jsonDocument, jsonString);
-
-  return jsonString;
 }
 
 void updateVolume()
@@ -217,24 +211,27 @@ void updateVolume()
   M5.Speaker.setVolume((int)(settings.Volume / 100.00f * 255.0f));
 }
 
-String getSettingsJson()
+// latest settings including a patch which is not applied by the loop yet
+Settings getSettings()
 {
-  JsonDocument jsonDocument;
-
-  jsonDocument["Volume"] = settings.Volume;
-  jsonDocument["LowerWindspeedThreshold"] = settings.LowerWindspeedThreshold;
-  jsonDocument["UpperWindspeedThreshold"] = settings.UpperWindspeedThreshold;
-  jsonDocument["WindspeedDurationRange"] = settings.WindspeedDurationRange;
-  jsonDocument["WindspeedEvaluationRange"] = settings.WindspeedEvaluationRange;
-  jsonDocument["WindspeedNumberOfWindows"] = settings.WindspeedNumberOfWindows;
-  jsonDocument["CalibrationFactor"] = settings.CalibrationFactor;
-  jsonDocument["DisplayBrightness"] = settings.DisplayBrightness;
-  jsonDocument["MaximumChargeCurrent"] = settings.MaximumChargeCurrent;
+  portENTER_CRITICAL(&pendingSettingsLock);
+  Settings latestSettings = pendingSettingsSubsystems != 0 ? pendingSettings : settings;
+  portEXIT_CRITICAL(&pendingSettingsLock);
+  return latestSettings;
+}
 
-  String jsonString;
-  jsonDocument.shrinkToFit();
-  serializeJson(jsonDocument, jsonString);
-  return jsonString;
+void addSettingsJson(JsonDocument &jsonDocument)
+{
+  Settings latestSettings = getSettings();
+  jsonDocument["Volume"] = latestSettings.Volume;
+  jsonDocument["LowerWindspeedThreshold"] = latestSettings.LowerWindspeedThreshold;
+  jsonDocument["UpperWindspeedThreshold"] = latestSettings.UpperWindspeedThreshold;
+  jsonDocument["WindspeedDurationRange"] = latestSettings.WindspeedDurationRange;
+  jsonDocument["WindspeedEvaluationRange"] = latestSettings.WindspeedEvaluationRange;
+  jsonDocument["WindspeedNumberOfWindows"] = latestSettings.WindspeedNumberOfWindows;
+  jsonDocument["CalibrationFactor"] = latestSettings.CalibrationFactor;
+  jsonDocument["DisplayBrightness"] = latestSettings.DisplayBrightness;
+  jsonDocument["MaximumChargeCurrent"] = latestSettings.MaximumChargeCurrent;
 }
 
 String getTimestampString()
@@ -245,36 +242,211 @@ String getTimestampString()
   return String(stringbuffer);
 }
 
-String getStatusJson()
+void addStatusJson(JsonDocument &jsonDocument)
 {
-
-  JsonDocument jsonDocument;
-
-  jsonDocument["BatteryLevel"] = M5.Power.getBatteryLevel();
-  jsonDocument["Current"] = M5.Power.getBatteryCurrent();
-  jsonDocument["IsPowerConnected"] = M5.Power.Axp192.isACIN();
-  jsonDocument["IsCharging"] = M5.Power.isCharging();
+  TelemetryData telemetryData = telemetry.getData();
+  jsonDocument["BatteryLevel"] = telemetryData.BatteryLevel;
+  jsonDocument["Current"] = telemetryData.BatteryCurrent;
+  jsonDocument["IsPowerConnected"] = telemetryData.IsPowerConnected;
+  jsonDocument["IsCharging"] = telemetryData.IsCharging;
   jsonDocument["WifiIpAddress"] = isAPModeActive ? WiFi.softAPIP() : WiFi.localIP();
-  jsonDocument["WifiRSSI"] = WiFi.RSSI();
+  jsonDocument["WifiRSSI"] = telemetryData.WifiRSSI;
   jsonDocument["WifiMode"] = isAPModeActive ? "Accesspoint" : "WiFi";
   jsonDocument["WifiSSID"] = isAPModeActive ? AP_SSID : "NONE";
   jsonDocument["WifiHostname"] = String("http://") + MDNSNAME + String(".local");
   jsonDocument["DateTime"] = getTimestampString();
   jsonDocument["FirmwareVersion"] = String(FWVERSION);
+  jsonDocument["DroppedSnapshots"] = windSpeed.getDroppedSnapshotCount();
+
+  TimeSyncStatus timeSyncStatus = timeSync.getStatus();
+  JsonObject timeSyncJson = jsonDocument["TimeSync"].to<JsonObject>();
+  timeSyncJson["IsSynchronized"] = timeSyncStatus.IsSynchronized;
+  timeSyncJson["IsSlewing"] = timeSyncStatus.IsSlewing;
+  timeSyncJson["NumberOfSyncs"] = timeSyncStatus.NumberOfSyncs;
+  timeSyncJson["NumberOfSteps"] = timeSyncStatus.NumberOfSteps;
+  timeSyncJson["LastOffset"] = timeSyncStatus.LastOffset;
+  timeSyncJson["LastSyncTime"] = (uint32_t)timeSyncStatus.LastSyncTime;
+
+  SamplingStatus samplingStatus = windSpeed.getSnapshot().Sampling;
+  JsonObject samplingJson = jsonDocument["Sampling"].to<JsonObject>();
+  samplingJson["LastInterval"] = samplingStatus.LastInterval;
+  samplingJson["LastQuality"] = samplingStatus.LastQuality;
+  samplingJson["Samples"] = samplingStatus.NumberOfSamples;
+  samplingJson["LateSamples"] = samplingStatus.NumberOfLateSamples;
+  samplingJson["Gaps"] = samplingStatus.NumberOfGaps;
+  samplingJson["MissedSamples"] = samplingStatus.NumberOfMissedSamples;
+
+  JsonArray spiBusJson = jsonDocument["SpiBus"].to<JsonArray>();
+  for (uint8_t i = 0; i < SPI_BUS_NUMBER_OF_PRIORITIES; i++)
+  {
+    SpiBusStatistics spiBusStatistics = spiBus.getStatistics((SpiBusPriority)i);
+    JsonObject spiBusClientJson = spiBusJson.add<JsonObject>();
+    spiBusClientJson["Client"] = SPI_BUS_PRIORITY_NAMES[i];
+    spiBusClientJson["Grants"] = spiBusStatistics.NumberOfGrants;
+    spiBusClientJson["Timeouts"] = spiBusStatistics.NumberOfTimeouts;
+    spiBusClientJson["MaxWaitTime"] = spiBusStatistics.MaxWaitTime;
+  }
+
+  SettingsStoreStatistics settingsStoreStatistics = settingsStore.getStatistics();
+  JsonObject settingsStoreJson = jsonDocument["SettingsStore"].to<JsonObject>();
+  settingsStoreJson["IsDirty"] = settingsStore.isDirty();
+  settingsStoreJson["Writes"] = settingsStoreStatistics.NumberOfWrites;
+  settingsStoreJson["SkippedWrites"] = settingsStoreStatistics.NumberOfSkippedWrites;
+  settingsStoreJson["CoalescedChanges"] = settingsStoreStatistics.NumberOfCoalescedChanges;
+  settingsStoreJson["FailedWrites"] = settingsStoreStatistics.NumberOfFailedWrites;
+
+  JsonArenaStatistics jsonArenaStatistics = jsonArenaPool.getStatistics();
+  JsonObject jsonArenaJson = jsonDocument["JsonArena"].to<JsonObject>();
+  jsonArenaJson["Arenas"] = jsonArenaStatistics.NumberOfArenas;
+  jsonArenaJson["Size"] = jsonArenaStatistics.ArenaSize;
+  jsonArenaJson["IsPsram"] = jsonArenaStatistics.IsPsram;
+  jsonArenaJson["Leases"] = jsonArenaStatistics.NumberOfLeases;
+  jsonArenaJson["MissingArenas"] = jsonArenaStatistics.NumberOfMissingArenas;
+  jsonArenaJson["Fallbacks"] = jsonArenaStatistics.NumberOfFallbacks;
+  jsonArenaJson["PeakUsage"] = jsonArenaStatistics.PeakUsage;
+
+  JsonObject admissionJson = jsonDocument["Admission"].to<JsonObject>();
+  admissionJson["FreeHeap"] = ESP.getFreeHeap();
+  admissionJson["HeapRejections"] = admissionControl.getNumberOfHeapRejections();
+  for (uint8_t i = 0; i < ADMISSION_NUMBER_OF_CLASSES; i++)
+  {
+    admissionJson["ActiveRequests"][ADMISSION_CLASS_NAMES[i]] = admissionControl.getNumberOfActiveRequests((AdmissionClass)i);
+  }
+  JsonArray admissionEndpointsJson = admissionJson["Endpoints"].to<JsonArray>();
+  for (uint8_t i = 0; i < admissionControl.getNumberOfEndpoints(); i++)
+  {
+    AdmissionEndpoint endpoint = admissionControl.getEndpoint(i);
+    JsonObject endpointJson = admissionEndpointsJson.add<JsonObject>();
+    endpointJson["Endpoint"] = endpoint.Name;
+    endpointJson["Admitted"] = endpoint.NumberOfAdmittedRequests;
+    endpointJson["Rejected"] = endpoint.NumberOfRejectedRequests;
+  }
+
+  JsonArray bootJson = jsonDocument["Boot"].to<JsonArray>();
+  for (uint8_t i = 0; i < bootProfiler.getNumberOfStages(); i++)
+  {
+    BootStage bootStage = bootProfiler.getStage(i);
+    JsonObject bootStageJson = bootJson.add<JsonObject>();
+    bootStageJson["Stage"] = bootStage.Name;
+    bootStageJson["Start"] = bootStage.Start;
+    if (bootStage.IsFinished)
+    {
+      bootStageJson["Duration"] = bootStage.Duration;
+    }
+    else
+    {
+      bootStageJson["Duration"] = nullptr;
+    }
+  }
+}
+
+// the json is built and serialized in a leased arena and sent from there, the arena is given back
+// when the response is destroyed after it has been sent
+void sendJson(AsyncWebServerRequest *request, std::function<void(JsonDocument &)> addJson)
+{
+  std::shared_ptr<JsonArenaDocument> document = std::make_shared<JsonArenaDocument>(jsonArenaPool);
+  addJson(document->getDocument());
+  size_t length = document->serialize();
+  if (length == 0)
+  {
+    request->send(500, "text/plain", "Out of memory");
+    return;
+  }
+  AsyncWebServerResponse *response = request->beginResponse("application/json", length, [document](uint8_t *buffer, size_t maxLength, size_t index) -> size_t
+                                                            { return document->read(buffer, maxLength, index); });
+  request->send(response);
+}
+
+// only the given subsystems are updated, e.g. the charge current is only written over i2c if it changed
+void applySettings(uint8_t subsystems)
+{
+  if (subsystems & SETTINGS_SUBSYSTEM_WINDSPEED)
+  {
+    windSpeed.updateSettings(settings.LowerWindspeedThreshold, settings.UpperWindspeedThreshold, settings.WindspeedDurationRange, settings.WindspeedEvaluationRange, settings.WindspeedNumberOfWindows, settings.CalibrationFactor);
+  }
+  if (subsystems & SETTINGS_SUBSYSTEM_DISPLAY)
+  {
+    windSpeedDisplay.updateSettings(settings.LowerWindspeedThreshold, settings.UpperWindspeedThreshold, settings.WindspeedEvaluationRange, settings.WindspeedDurationRange, settings.DisplayBrightness);
+  }
+  if (subsystems & SETTINGS_SUBSYSTEM_SPEAKER)
+  {
+    updateVolume();
+  }
+  if (subsystems & SETTINGS_SUBSYSTEM_POWER)
+  {
+    M5.Power.Axp192.setChargeCurrent(settings.MaximumChargeCurrent);
+  }
+  settingsStore.markDirty();
+}
 
-  String jsonString;
-  jsonDocument.shrinkToFit();
-  serializeJson(jsonDocument, jsonString);
-  return jsonString;
+// the settings patched by the web server are copied here, so they are only written by the loop
+void applyPendingSettings()
+{
+  portENTER_CRITICAL(&pendingSettingsLock);
+  uint8_t subsystems = pendingSettingsSubsystems;
+  if (subsystems != 0)
+  {
+    settings = pendingSettings;
+    pendingSettingsSubsystems = 0;
+  }
+  portEXIT_CRITICAL(&pendingSettingsLock);
+  if (subsystems != 0)
+  {
+    applySettings(subsystems);
+  }
 }
 
 void updateSettings()
 {
-  windSpeed.updateSettings(settings.LowerWindspeedThreshold, settings.UpperWindspeedThreshold, settings.WindspeedDurationRange, settings.WindspeedEvaluationRange, settings.WindspeedNumberOfWindows, settings.CalibrationFactor);
-  windSpeedDisplay.updateSettings(settings.LowerWindspeedThreshold, settings.UpperWindspeedThreshold, settings.WindspeedEvaluationRange, settings.WindspeedDurationRange, settings.DisplayBrightness);
-  updateVolume();
-  M5.Power.Axp192.setChargeCurrent(settings.MaximumChargeCurrent);
-  saveSettings();
+  applySettings(SETTINGS_SUBSYSTEM_ALL);
+}
+
+// renders a binary snapshot into the requested format while the response is sent
+void sendSnapshot(AsyncWebServerRequest *request, const String &filename, const String &snapshotPath, SnapshotFormat format)
+{
+  std::shared_ptr<SnapshotRenderer> renderer = std::make_shared<SnapshotRenderer>();
+  bool isOpened;
+  {
+    SpiBusLock lock(&spiBus, SpiBusPriority::DOWNLOAD, FILE_DOWNLOAD_OPEN_TIMEOUT);
+    isOpened = lock.isAcquired() && renderer->open(SD, snapshotPath.c_str(), format);
+  }
+  if (!isOpened)
+  {
+    request->send(404, "text/plain", "Snapshot not found");
+    return;
+  }
+  AsyncWebServerResponse *response = request->beginChunkedResponse(SnapshotRenderer::getContentType(format), [renderer](uint8_t *buffer, size_t maxLength, size_t index) -> size_t
+                                                                    { return renderer->read(buffer, maxLength); });
+  response->addHeader("Content-Disposition", "attachment; filename=\"" + filename + "\"");
+  request->send(response);
+}
+
+const char *getDownloadContentType(const String &filename)
+{
+  if (filename.endsWith(".csv"))
+  {
+    return "text/csv";
+  }
+  if (filename.endsWith(".json"))
+  {
+    return "application/json";
+  }
+  return "application/octet-stream";
+}
+
+// log files are read in chunks, the spi bus is released between the chunks
+void sendFile(AsyncWebServerRequest *request, const String &filename, const String &filePath)
+{
+  std::shared_ptr<FileDownload> download = std::make_shared<FileDownload>(&spiBus);
+  if (!download->open(SD, filePath.c_str()))
+  {
+    request->send(404, "text/plain", "File not found");
+    return;
+  }
+  AsyncWebServerResponse *response = request->beginResponse(getDownloadContentType(filename), download->getSize(), [download](uint8_t *buffer, size_t maxLength, size_t index) -> size_t
+                                                            { return download->read(buffer, maxLength, index); });
+  response->addHeader("Content-Disposition", "attachment; filename=\"" + filename + "\"");
+  request->send(response);
 }
 
 void handleDownloadRequest(AsyncWebServerRequest *request)
@@ -313,53 +485,57 @@ void handleDownloadRequest(AsyncWebServerRequest *request)
     Serial.println(parameter->value());
     String filename = request->getParam("filename")->value();
     Serial.println("Download Filename: " + filename);
-    request->send(SD, "/logs/" + filename, String(), true);
+    String snapshotPath;
+    SnapshotFormat snapshotFormat;
+    if (!existsSDFile("/logs/" + filename) && SnapshotRenderer::getSnapshotPath("/logs/" + filename, snapshotPath, snapshotFormat))
+    {
+      sendSnapshot(request, filename, snapshotPath, snapshotFormat);
+      return;
+    }
+    sendFile(request, filename, "/logs/" + filename);
     return;
   }
   else
   {
-    request->send_P(200, "application/json", getDownloadFilesJson().c_str());
+    sendJson(request, addDownloadFilesJson);
   }
 }
 
-void playSound(uint32_t duration = 4294967295U, float frequency = 440.0f)
-{
-  M5.Speaker.tone(frequency, duration);
-}
+// sound patterns, played by the sound sequencer from the loop
+static const SoundTone switchOnTones[] = {{440.0f, 200}, {880.0f, 200}, {1320.0f, 200}};
+static const SoundTone switchOffTones[] = {{1320.0f, 200}, {880.0f, 200}, {440.0f, 200}};
+static const SoundTone alarmTones[][1] = {{{440.0f, 1000}}, {{880.0f, 1000}}, {{1320.0f, 1000}}};
+static const SoundPattern switchOnPattern = {switchOnTones, 3, 1};
+static const SoundPattern switchOffPattern = {switchOffTones, 3, 1};
+static const SoundPattern alarmPatterns[] = {{alarmTones[0], 1, SOUND_PATTERN_ENDLESS}, {alarmTones[1], 1, SOUND_PATTERN_ENDLESS}, {alarmTones[2], 1, SOUND_PATTERN_ENDLESS}};
 
+// an active alarm is stopped, otherwise the switch off pattern would wait behind the endless alarm pattern
 void playSwitchOffSound()
 {
   if (!isSwitchoffSoundActive)
   {
     isSwitchoffSoundActive = true;
-    int delayTime = 200;
-    playSound(delayTime, 1320.0f);
-    M5.delay(delayTime);
-    playSound(delayTime, 880.0f);
-    M5.delay(delayTime);
-    playSound(delayTime, 440.0f);
-    M5.delay(delayTime);
+    soundSequencer.stop();
+    isAlarmActive = false;
+    soundSequencer.play(&switchOffPattern);
   }
 }
 
 void playSwitchOnSound()
 {
-  int delayTime = 200;
-  playSound(delayTime, 440.0f);
-  M5.delay(delayTime);
-  playSound(delayTime, 880.0f);
-  M5.delay(delayTime);
-  playSound(delayTime, 1320.0f);
-  M5.delay(delayTime);
+  soundSequencer.play(&switchOnPattern);
 }
 
-void playAlarmSound() {
-    playSound();
+// sound patterns selectable by the alarm rules, the alarm sounds until it is stopped
+void playAlarmSound(uint8_t soundPattern = 0)
+{
+  soundSequencer.stop();
+  soundSequencer.play(&alarmPatterns[soundPattern % (sizeof(alarmPatterns) / sizeof(alarmPatterns[0]))]);
 }
 
 void stopSound()
 {
-  M5.Speaker.stop();
+  soundSequencer.stop();
 }
 
 void setupSoundModule()
@@ -385,6 +561,8 @@ void wifiManagerConfigModeCallback(WiFiManager *wifiManager)
   Serial.println("Entered wifi manager config mode");
   Serial.println(WiFi.softAPIP());
   Serial.println(wifiManager->getConfigPortalSSID());
+  isWifiConfigActive = true;
+  SpiBusLock lock(&spiBus, SpiBusPriority::DISPLAY, portMAX_DELAY);
   wifiConfigDisplay.setup();
   wifiConfigDisplay.draw(wifiManager->getConfigPortalSSID(), WiFi.softAPIP().toString());
 }
@@ -407,6 +585,11 @@ void setupWifi()
     bool res;
 
     res = wifiManager.autoConnect(AP_SSID);
+    if (isWifiConfigActive)
+    {
+      isWifiConfigActive = false;
+      isWifiConfigFinished = true;
+    }
 
     if (!res)
     {
@@ -423,93 +606,344 @@ void setupWifi()
   setupDns();
 }
 
-void setupRtcTimeSyncProvider()
+// TimeLib only reads the system time, which is set from the rtc and kept in sync by sntp
+void setupTime()
+{
+  timeSync.setupRtc();
+  setSyncProvider(TimeSync::getSystemTime);
+  setSyncInterval(SYSTEM_TIME_SYNC_INTERVAL);
+}
+
+void setupTimeSync()
+{
+  if (isWifiOn && !isAPModeActive)
+  {
+    timeSync.begin(ntpServerName, TIME_SYNC_INTERVAL);
+  }
+}
+
+void alarmCallback(uint8_t ruleIndex, const AlarmRule &rule)
+{
+  if (rule.Actions & ALARM_ACTION_SOUND)
+  {
+    isAlarmActive = true;
+    playAlarmSound(rule.SoundPattern);
+  }
+  if (rule.Actions & ALARM_ACTION_EVENT)
+  {
+    char eventData[100];
+    snprintf(eventData, sizeof(eventData), "{\"Rule\":%u,\"Type\":\"%s\",\"Windspeed\":%.1f}", ruleIndex, ALARM_RULE_TYPE_NAMES[(uint8_t)rule.Type], windSpeed.getCurrentWindspeed());
+    events.send(eventData, "alarm", millis());
+  }
+}
+
+void startButtonCallback(bool isWifiEnabled, bool isAPEnabled)
+{
+  isAPModeActive = isAPEnabled;
+  isWifiOn = isWifiEnabled;
+  isStartupActive = false;
+}
+
+void setupWindspeedIO()
 {
-  setSyncProvider(getRtcTime);
-  setSyncInterval(TIME_SYNC_INTERVAL);
+#ifdef WINDSPEED_PULSE_SOURCE_PCNT
+  windSpeed.setupPulseSource(&pcntPulseSource);
+#else
+  windSpeed.setupPulseSource();
+#endif
+  windSpeed.setupAlarmCallback(&alarmCallback);
+  windSpeed.setupTelemetry(&telemetry);
+  windSpeed.setupStatisticsWindows(statisticsWindows, sizeof(statisticsWindows) / sizeof(statisticsWindows[0]));
 }
 
-void setupNtpTimeSyncProvider()
+// the body could arrive in several chunks, it is collected in the temp object of the request,
+// which is freed together with the request, returns the body once it is complete
+RequestBody *collectRequestBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total, size_t maxSize)
 {
-  Serial.println("Starting UDP");
-  Udp.begin(localPort);
-  Serial.println("waiting for sync");
-  setSyncProvider(getNtpTime);
-  setSyncInterval(TIME_SYNC_INTERVAL);
-  Serial.println("NTP Sync done");
+  if (index == 0 && request->_tempObject == nullptr && total > 0 && total <= maxSize)
+  {
+    RequestBody *body = (RequestBody *)malloc(sizeof(RequestBody) + total);
+    if (body != nullptr)
+    {
+      body->Length = 0;
+      body->IsApplied = false;
+      body->Error = nullptr;
+      body->Field = nullptr;
+    }
+    request->_tempObject = body;
+  }
+
+  RequestBody *body = (RequestBody *)request->_tempObject;
+  if (body == nullptr || index != body->Length || index + len > total)
+  {
+    return nullptr;
+  }
+  memcpy((uint8_t *)(body + 1) + index, data, len);
+  body->Length += len;
+  return body->Length == total ? body : nullptr;
 }
 
-void setupRtc()
+// applied as partial patch to a copy of the latest settings once it is complete, the copy is handed
+// to the loop, so the settings are never written from the web server task
+void parseSettingsBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
 {
+  RequestBody *body = collectRequestBody(request, data, len, index, total, SETTINGS_MAX_BODY_SIZE);
+  if (body == nullptr)
+  {
+    return;
+  }
 
-  if (!M5.Rtc.isEnabled())
+  JsonArenaLease arena(jsonArenaPool);
+  JsonDocument bodyJSON(arena.getAllocator());
+  if (deserializeJson(bodyJSON, (const char *)(body + 1), body->Length))
+  {
+    body->Error = "Invalid json";
+    return;
+  }
+  Settings patchedSettings = getSettings();
+  SettingsPatchResult result = applySettingsPatch(patchedSettings, bodyJSON.as<JsonVariantConst>());
+  body->Error = result.Error;
+  body->Field = result.Field;
+  if (!result.IsValid)
   {
-    Serial.println("RTC not found.");
     return;
   }
+  portENTER_CRITICAL(&pendingSettingsLock);
+  pendingSettings = patchedSettings;
+  pendingSettingsSubsystems |= result.ChangedSubsystems;
+  portEXIT_CRITICAL(&pendingSettingsLock);
+  body->IsApplied = true;
+}
 
-  Serial.println("RTC found.");
-  auto dt = M5.Rtc.getDateTime();
+void saveCalibration()
+{
+  CalibrationPoint points[CALIBRATION_MAX_POINTS];
+  uint8_t numberOfPoints = windSpeed.getCalibrationPoints(points, CALIBRATION_MAX_POINTS);
+  preferences.begin(PREFERENCE_NAMESPACE, false);
+  preferences.putBytes(CALIBRATION_PREFERENCE_KEY, points, numberOfPoints * sizeof(CalibrationPoint));
+  preferences.end();
+  Serial.println("Calibration saved");
+}
 
-  if (!isWifiOn || isAPModeActive)
+void setupCalibration()
+{
+  CalibrationPoint points[CALIBRATION_MAX_POINTS];
+  size_t length = 0;
+  preferences.begin(PREFERENCE_NAMESPACE, true);
+  if (preferences.isKey(CALIBRATION_PREFERENCE_KEY))
   {
-    setupRtcTimeSyncProvider();
+    length = preferences.getBytes(CALIBRATION_PREFERENCE_KEY, points, sizeof(points));
   }
-  else
+  preferences.end();
+  if (length > 0 && !windSpeed.setCalibrationPoints(points, length / sizeof(CalibrationPoint)))
+  {
+    Serial.println("Stored calibration invalid, using default calibration");
+  }
+}
+
+// calibration points with frequency in Hz and windspeed in m/s, converted to fixed point once here
+void parseCalibrationBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+{
+  RequestBody *body = collectRequestBody(request, data, len, index, total, CALIBRATION_MAX_BODY_SIZE);
+  if (body == nullptr)
+  {
+    return;
+  }
+
+  JsonArenaLease arena(jsonArenaPool);
+  JsonDocument bodyJSON(arena.getAllocator());
+  if (deserializeJson(bodyJSON, (const char *)(body + 1), body->Length))
   {
-    setupNtpTimeSyncProvider();
+    return;
   }
 
-  // update RTC with current system time
-  time_t t = now();
-  M5.Rtc.setDateTime(gmtime(&t));
+  CalibrationPoint points[CALIBRATION_MAX_POINTS];
+  size_t numberOfPoints = 0;
+  for (JsonObject pointJSON : bodyJSON["Points"].as<JsonArray>())
+  {
+    float frequency = pointJSON["Frequency"] | -1.0f;
+    float windspeed = pointJSON["Windspeed"] | -1.0f;
+    if (numberOfPoints >= CALIBRATION_MAX_POINTS || frequency < 0.0f || windspeed < 0.0f)
+    {
+      return;
+    }
+    points[numberOfPoints].Frequency = (uint32_t)(frequency * 1000.0f + 0.5f);
+    points[numberOfPoints].Windspeed = (uint32_t)(windspeed * 1000.0f + 0.5f);
+    numberOfPoints++;
+  }
+
+  if (!windSpeed.setCalibrationPoints(points, numberOfPoints))
+  {
+    return;
+  }
+  saveCalibration();
+  body->IsApplied = true;
 }
 
-void evaluationCallback()
+void handleCalibration(AsyncWebServerRequest *request)
 {
-  isAlarmActive = true;
-  playAlarmSound();
+  Serial.println("handleCalibration");
+  RequestBody *body = (RequestBody *)request->_tempObject;
+  if (request->contentLength() > CALIBRATION_MAX_BODY_SIZE)
+  {
+    request->send(413, "text/plain", "Calibration too large");
+    return;
+  }
+  if (body == nullptr || !body->IsApplied)
+  {
+    request->send(400, "text/plain", "Invalid calibration points");
+    return;
+  }
+  sendJson(request, [](JsonDocument &jsonDocument)
+           { windSpeed.addCalibrationJson(jsonDocument); });
 }
 
-void startButtonCallback(bool isWifiEnabled, bool isAPEnabled)
+void saveAlarmRules()
 {
-  isAPModeActive = isAPEnabled;
-  isWifiOn = isWifiEnabled;
-  isStartupActive = false;
+  AlarmRule rules[ALARM_MAX_RULES];
+  uint8_t numberOfRules = windSpeed.getAlarmRules(rules, ALARM_MAX_RULES);
+  preferences.begin(PREFERENCE_NAMESPACE, false);
+  preferences.putBytes(ALARM_RULES_PREFERENCE_KEY, rules, numberOfRules * sizeof(AlarmRule));
+  preferences.end();
+  Serial.println("Alarm rules saved");
 }
 
-void setupWindspeedIO()
+void setupAlarmRules()
 {
-  windSpeed.setupInterruptCallback(interruptCallback);
-  windSpeed.setupEvaluationCallback(&evaluationCallback);
-}
-
-// callback definition
-void parseMyPageBody(AsyncWebServerRequest *req, uint8_t *data, size_t len, size_t index, size_t total)
-{
-  DynamicJsonDocument bodyJSON(1024);
-  deserializeJson(bodyJSON, data, len);
-  int volume = bodyJSON["Volume"];
-  int lowerWindspeedThreshold = bodyJSON["LowerWindspeedThreshold"];
-  int upperWindspeedThreshold = bodyJSON["UpperWindspeedThreshold"];
-  settings.WindspeedDurationRange = bodyJSON["WindspeedDurationRange"];
-  settings.WindspeedNumberOfWindows = bodyJSON["WindspeedNumberOfWindows"];
-  // int calibrationValue = bodyJSON["CalibrationValue"];
-  int displayBrightness = bodyJSON["DisplayBrightness"];
-  int maximumChargeCurrent = bodyJSON["MaximumChargeCurrent"];
-  settings.Volume = volume;
-  settings.LowerWindspeedThreshold = lowerWindspeedThreshold;
-  settings.UpperWindspeedThreshold = upperWindspeedThreshold;
-  // settings.CalibrationFactor = calibrationValue;
-  settings.DisplayBrightness = displayBrightness;
-  settings.MaximumChargeCurrent = maximumChargeCurrent;
-  updateSettings();
+  AlarmRule rules[ALARM_MAX_RULES];
+  size_t length = 0;
+  bool isStored = false;
+  preferences.begin(PREFERENCE_NAMESPACE, true);
+  if (preferences.isKey(ALARM_RULES_PREFERENCE_KEY))
+  {
+    isStored = true;
+    length = preferences.getBytes(ALARM_RULES_PREFERENCE_KEY, rules, sizeof(rules));
+  }
+  preferences.end();
+  if (isStored && (length % sizeof(AlarmRule) != 0 || !windSpeed.setAlarmRules(rules, length / sizeof(AlarmRule))))
+  {
+    Serial.println("Stored alarm rules invalid, using default alarm rules");
+  }
+}
+
+int findName(const char *name, const char *const *names, size_t numberOfNames)
+{
+  for (size_t i = 0; name != nullptr && i < numberOfNames; i++)
+  {
+    if (strcmp(name, names[i]) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// compiles the rules from the settings api into the compact rule table, windspeeds in m/s
+void parseAlarmRulesBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+{
+  RequestBody *body = collectRequestBody(request, data, len, index, total, ALARM_RULES_MAX_BODY_SIZE);
+  if (body == nullptr)
+  {
+    return;
+  }
+
+  JsonArenaLease arena(jsonArenaPool);
+  JsonDocument bodyJSON(arena.getAllocator());
+  if (deserializeJson(bodyJSON, (const char *)(body + 1), body->Length))
+  {
+    return;
+  }
+
+  AlarmRule rules[ALARM_MAX_RULES];
+  size_t numberOfRules = 0;
+  for (JsonObject ruleJSON : bodyJSON.as<JsonArray>())
+  {
+    if (numberOfRules >= ALARM_MAX_RULES)
+    {
+      return;
+    }
+    int type = findName(ruleJSON["Type"], ALARM_RULE_TYPE_NAMES, sizeof(ALARM_RULE_TYPE_NAMES) / sizeof(ALARM_RULE_TYPE_NAMES[0]));
+    int comparison = findName(ruleJSON["Comparison"] | "Outside", ALARM_COMPARISON_NAMES, sizeof(ALARM_COMPARISON_NAMES) / sizeof(ALARM_COMPARISON_NAMES[0]));
+    if (type < 0 || comparison < 0)
+    {
+      return;
+    }
+    AlarmRule &rule = rules[numberOfRules];
+    rule.Type = (AlarmRuleType)type;
+    rule.Comparison = (AlarmComparison)comparison;
+    float thresholdScale = rule.Type == AlarmRuleType::EXCEEDED_WINDOWS ? 1.0f : 10.0f;
+    rule.Threshold = (int16_t)lroundf((ruleJSON["Threshold"] | 0.0f) * thresholdScale);
+    if (rule.Type == AlarmRuleType::HYSTERESIS && !ruleJSON["ReleaseThreshold"].is<float>())
+    {
+      return;
+    }
+    rule.ReleaseThreshold = (int16_t)lroundf((ruleJSON["ReleaseThreshold"] | 0.0f) * 10.0f);
+    rule.Duration = ruleJSON["Duration"] | 0;
+    rule.SoundPattern = ruleJSON["SoundPattern"] | 0;
+    rule.Actions = 0;
+    for (const char *action : ruleJSON["Actions"].as<JsonArray>())
+    {
+      int actionIndex = findName(action, ALARM_ACTION_NAMES, sizeof(ALARM_ACTION_NAMES) / sizeof(ALARM_ACTION_NAMES[0]));
+      if (actionIndex < 0)
+      {
+        return;
+      }
+      rule.Actions |= 1 << actionIndex;
+    }
+    numberOfRules++;
+  }
+
+  if (!windSpeed.setAlarmRules(rules, numberOfRules))
+  {
+    return;
+  }
+  saveAlarmRules();
+  body->IsApplied = true;
+}
+
+void handleAlarmRules(AsyncWebServerRequest *request)
+{
+  Serial.println("handleAlarmRules");
+  RequestBody *body = (RequestBody *)request->_tempObject;
+  if (request->contentLength() > ALARM_RULES_MAX_BODY_SIZE)
+  {
+    request->send(413, "text/plain", "Alarm rules too large");
+    return;
+  }
+  if (body == nullptr || !body->IsApplied)
+  {
+    request->send(400, "text/plain", "Invalid alarm rules");
+    return;
+  }
+  sendJson(request, [](JsonDocument &jsonDocument)
+           { windSpeed.addAlarmRulesJson(jsonDocument); });
 }
 
 void handleSettings(AsyncWebServerRequest *request)
 {
   Serial.println("handleSettings");
-  request->send_P(200, "application/json", getSettingsJson().c_str());
+  RequestBody *body = (RequestBody *)request->_tempObject;
+  if (request->contentLength() > SETTINGS_MAX_BODY_SIZE)
+  {
+    request->send(413, "text/plain", "Settings too large");
+    return;
+  }
+  if (body == nullptr)
+  {
+    request->send(400, "text/plain", "Missing settings");
+    return;
+  }
+  if (!body->IsApplied)
+  {
+    String error = body->Error != nullptr ? body->Error : "Incomplete settings";
+    if (body->Field != nullptr)
+    {
+      error += String(": ") + body->Field;
+    }
+    request->send(400, "text/plain", error);
+    return;
+  }
+  sendJson(request, addSettingsJson);
 }
 
 void handleResetWifi(AsyncWebServerRequest *request)
@@ -519,31 +953,113 @@ void handleResetWifi(AsyncWebServerRequest *request)
   request->send(200, "text/plain", "Resetting WiFi settings");
 }
 
+// GET endpoint behind the admission control, the write endpoints are admitted by a gate before their body is applied
+void onAdmittedRequest(const char *uri, AdmissionClass admissionClass, uint8_t maxConcurrentRequests, uint8_t budget, uint16_t refillInterval, ArRequestHandlerFunction handler)
+{
+  int8_t endpoint = admissionControl.addEndpoint(uri, admissionClass, maxConcurrentRequests, budget, refillInterval);
+  server.on(uri, HTTP_GET, admissionControl.wrap(endpoint, [handler, uri](AsyncWebServerRequest *request)
+                                                 {
+                                                   MetricsTimer timer(&metrics, MetricsTiming::WEB_HANDLER);
+                                                   TRACE_SPAN(uri);
+                                                   handler(request);
+                                                 }));
+}
+
+// write endpoint behind the admission control, the gate has to be added before the handlers of the endpoint
+void addAdmissionGate(const char *name, const char *uri, WebRequestMethodComposite method, AdmissionClass admissionClass, uint8_t maxConcurrentRequests, uint8_t budget, uint16_t refillInterval)
+{
+  int8_t endpoint = admissionControl.addEndpoint(name, admissionClass, maxConcurrentRequests, budget, refillInterval);
+  server.addHandler(new AdmissionGate(&admissionControl, uri, method, endpoint));
+}
+
+#if TRACER_ENABLED
+// chrome trace event json of the last spans, could be opened in a trace viewer (e.g. ui.perfetto.dev)
+void handleTrace(AsyncWebServerRequest *request)
+{
+  std::shared_ptr<TraceExport> traceExport = std::make_shared<TraceExport>(tracer);
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json", [traceExport](uint8_t *buffer, size_t maxLength, size_t index) -> size_t
+                                                                    { return traceExport->read(buffer, maxLength); });
+  response->addHeader("Content-Disposition", "attachment; filename=\"fxwind_trace.json\"");
+  request->send(response);
+}
+#endif
+
+// prometheus text format
+void handleMetrics(AsyncWebServerRequest *request)
+{
+  AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+  metrics.printPrometheus(*response);
+  SamplingStatus samplingStatus = windSpeed.getSnapshot().Sampling;
+  Metrics::printPrometheusValue(*response, "fxwind_samples_total", "counter", "Number of samples", samplingStatus.NumberOfSamples);
+  Metrics::printPrometheusValue(*response, "fxwind_late_samples_total", "counter", "Number of samples later than the tolerance", samplingStatus.NumberOfLateSamples);
+  Metrics::printPrometheusValue(*response, "fxwind_sample_gaps_total", "counter", "Number of samples after at least one whole sample period without a sample", samplingStatus.NumberOfGaps);
+  Metrics::printPrometheusValue(*response, "fxwind_missed_samples_total", "counter", "Number of sample periods without a sample", samplingStatus.NumberOfMissedSamples);
+  Metrics::printPrometheusValue(*response, "fxwind_sample_interval_seconds", "gauge", "Interval of the last sample", samplingStatus.LastInterval / 1000.0);
+  Metrics::printPrometheusValue(*response, "fxwind_pulses_total", "counter", "Anemometer pulses", windSpeed.getPulseCount());
+  Metrics::printPrometheusValue(*response, "fxwind_pulse_frequency_hertz", "gauge", "Anemometer pulse frequency of the last sample", windSpeed.getPulseFrequency());
+  Metrics::printPrometheusValue(*response, "fxwind_pulse_glitches_total", "counter", "Rejected anemometer edges", windSpeed.getPulseGlitchCount());
+  Metrics::printPrometheusValue(*response, "fxwind_pulse_overruns_total", "counter", "Anemometer edges lost in the capture buffer", windSpeed.getPulseOverrunCount());
+  Metrics::printPrometheusValue(*response, "fxwind_heap_free_bytes", "gauge", "Free heap", ESP.getFreeHeap());
+  Metrics::printPrometheusValue(*response, "fxwind_heap_min_free_bytes", "gauge", "Lowest free heap since the start", ESP.getMinFreeHeap());
+  Metrics::printPrometheusValue(*response, "fxwind_heap_largest_free_block_bytes", "gauge", "Largest free heap block", ESP.getMaxAllocHeap());
+  Metrics::printPrometheusValue(*response, "fxwind_psram_used_bytes", "gauge", "Used psram", ESP.getPsramSize() - ESP.getFreePsram());
+  Metrics::printPrometheusValue(*response, "fxwind_psram_size_bytes", "gauge", "Size of the psram", ESP.getPsramSize());
+  Metrics::printPrometheusValue(*response, "fxwind_uptime_seconds", "counter", "Time since the start", millis() / 1000.0);
+  request->send(response);
+}
 
 void setupServer()
 {
 
-  server.on("/chart.js", HTTP_GET, [](AsyncWebServerRequest *request)
-            { request->send(LittleFS, "/chart.js"); });
-  server.on("/favicon.ico", HTTP_GET, [](AsyncWebServerRequest *request)
-            { request->send(LittleFS, "/favicon.ico"); });
-  server.on("/", HTTP_GET, [](AsyncWebServerRequest *request)
-            { request->send(LittleFS, "/index.html"); });
-  server.on("/windspeed", HTTP_GET, [](AsyncWebServerRequest *request)
-            { request->send_P(200, "application/json", windSpeed.getWindspeedJson().c_str()); });
-  server.on("/evaluation", HTTP_GET, [](AsyncWebServerRequest *request)
-            { request->send_P(200, "application/json", windSpeed.getWindspeedEvaluationJson().c_str()); });
-  server.on("/downloads", HTTP_GET, [](AsyncWebServerRequest *request)
-            { handleDownloadRequest(request); });
-  server.on("/settings", HTTP_GET, [](AsyncWebServerRequest *request)
-            { request->send_P(200, "application/json", getSettingsJson().c_str()); });
-  server.on("/status", HTTP_GET, [](AsyncWebServerRequest *request)
-            { request->send_P(200, "application/json", getStatusJson().c_str()); });
-  server.on("/settings", HTTP_POST, handleSettings, nullptr, parseMyPageBody);
+  onAdmittedRequest("/chart.js", AdmissionClass::EXPENSIVE, PAGE_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { request->send(LittleFS, "/chart.js"); });
+  onAdmittedRequest("/favicon.ico", AdmissionClass::CHEAP, PAGE_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { request->send(LittleFS, "/favicon.ico"); });
+  onAdmittedRequest("/", AdmissionClass::EXPENSIVE, PAGE_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { request->send(LittleFS, "/index.html"); });
+  onAdmittedRequest("/windspeed", AdmissionClass::CHEAP, LIVE_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { sendJson(request, [](JsonDocument &jsonDocument)
+                               { windSpeed.addWindspeedJson(jsonDocument); }); });
+  onAdmittedRequest("/evaluation", AdmissionClass::CHEAP, LIVE_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { sendJson(request, [](JsonDocument &jsonDocument)
+                               { windSpeed.addWindspeedEvaluationJson(jsonDocument); }); });
+  onAdmittedRequest("/statistics", AdmissionClass::CHEAP, LIVE_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { sendJson(request, [](JsonDocument &jsonDocument)
+                               { windSpeed.addWindowStatisticsJson(jsonDocument); }); });
+  onAdmittedRequest("/histogram", AdmissionClass::CHEAP, LIVE_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { sendJson(request, [](JsonDocument &jsonDocument)
+                               { windSpeed.addWindspeedHistogramJson(jsonDocument); }); });
+  onAdmittedRequest("/downloads", AdmissionClass::EXPENSIVE, DOWNLOAD_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { handleDownloadRequest(request); });
+  onAdmittedRequest("/settings", AdmissionClass::CHEAP, CONFIGURATION_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { sendJson(request, addSettingsJson); });
+  onAdmittedRequest("/status", AdmissionClass::CHEAP, LIVE_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { sendJson(request, addStatusJson); });
+  onAdmittedRequest("/metrics", AdmissionClass::CHEAP, LIVE_REQUEST_LIMITS, handleMetrics);
+  addAdmissionGate("POST /settings", "/settings", HTTP_POST | HTTP_PATCH, AdmissionClass::CHEAP, WRITE_REQUEST_LIMITS);
+  server.on("/settings", HTTP_POST | HTTP_PATCH, handleSettings, nullptr, parseSettingsBody);
+  onAdmittedRequest("/calibration", AdmissionClass::CHEAP, CONFIGURATION_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { sendJson(request, [](JsonDocument &jsonDocument)
+                               { windSpeed.addCalibrationJson(jsonDocument); }); });
+  addAdmissionGate("POST /calibration", "/calibration", HTTP_POST, AdmissionClass::CHEAP, WRITE_REQUEST_LIMITS);
+  server.on("/calibration", HTTP_POST, handleCalibration, nullptr, parseCalibrationBody);
+  onAdmittedRequest("/alarms", AdmissionClass::CHEAP, CONFIGURATION_REQUEST_LIMITS, [](AsyncWebServerRequest *request)
+                    { sendJson(request, [](JsonDocument &jsonDocument)
+                               { windSpeed.addAlarmRulesJson(jsonDocument); }); });
+  addAdmissionGate("POST /alarms", "/alarms", HTTP_POST, AdmissionClass::CHEAP, WRITE_REQUEST_LIMITS);
+  server.on("/alarms", HTTP_POST, handleAlarmRules, nullptr, parseAlarmRulesBody);
+  addAdmissionGate("POST /resetwifi", "/resetwifi", HTTP_POST, AdmissionClass::CHEAP, WRITE_REQUEST_LIMITS);
   server.on("/resetwifi", HTTP_POST, handleResetWifi);
+  server.addHandler(&events);
+#if TRACER_ENABLED
+  onAdmittedRequest("/trace", AdmissionClass::EXPENSIVE, DOWNLOAD_REQUEST_LIMITS, handleTrace);
+#endif
 
   DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
 
+  // the firmware upload is flashed while it is received
+  addAdmissionGate("/update", "/update", HTTP_GET, AdmissionClass::EXPENSIVE, PAGE_REQUEST_LIMITS);
+  addAdmissionGate("POST /update", "/update", HTTP_POST, AdmissionClass::EXPENSIVE, UPDATE_REQUEST_LIMITS);
   updateServer.setup(&server);
 
   updateServer.onUpdateBegin = [](const UpdateType type, int &result)
@@ -567,25 +1083,10 @@ void setupLittleFS()
     return;
   }
 }
-void saveSettings()
-{
-  preferences.begin(PREFERENCE_NAMESPACE, false);
-  preferences.putInt("Volume", settings.Volume);
-  preferences.putInt("LowerThreshold", settings.LowerWindspeedThreshold);
-  preferences.putInt("UpperThreshold", settings.UpperWindspeedThreshold);
-  preferences.putInt("DurationRange", settings.WindspeedDurationRange);
-  preferences.putInt("EvaluationRange", settings.WindspeedEvaluationRange);
-  preferences.putInt("NumberOfWindows", settings.WindspeedNumberOfWindows);
-  preferences.putInt("Calibration", settings.CalibrationFactor);
-  preferences.putInt("Brightness", settings.DisplayBrightness);
-  preferences.putInt("MaxCurrent", settings.MaximumChargeCurrent);
-  preferences.end();
-  Serial.println("Preferences saved");
-}
-
-void setupPreferences()
+// single keys of the firmware versions before the settings blob
+void loadLegacySettings()
 {
-  preferences.begin(PREFERENCE_NAMESPACE, false);
+  preferences.begin(PREFERENCE_NAMESPACE, true);
   settings.Volume = preferences.getInt("Volume", VOLUME);
   settings.LowerWindspeedThreshold = preferences.getInt("LowerThreshold", WINDSPEED_LOWER_THRESHOLD);
   settings.UpperWindspeedThreshold = preferences.getInt("UpperThreshold", WINDSPEED_UPPER_THRESHOLD);
@@ -595,8 +1096,17 @@ void setupPreferences()
   settings.CalibrationFactor = preferences.getInt("Calibration", 1);
   settings.DisplayBrightness = preferences.getInt("Brightness", DISPLAY_BRIGHTNESS);
   settings.MaximumChargeCurrent = preferences.getInt("MaxCurrent", CHARGE_CURRENT);
-  preferences.end(); 
-  saveSettings();
+  preferences.end();
+}
+
+// the settings blob is only written if the settings are missing, invalid or changed
+void setupPreferences()
+{
+  if (!settingsStore.load())
+  {
+    loadLegacySettings();
+    settingsStore.markDirty();
+  }
   updateSettings();
 }
 
@@ -610,16 +1120,35 @@ void setupStartupLogo()
   display.clear();
 }
 
+// the touches of the startup display are evaluated in the loop until the start button is pressed
 void setupStartupDisplay()
 {
-  playSwitchOnSound();
+  SpiBusLock lock(&spiBus, SpiBusPriority::DISPLAY, portMAX_DELAY);
   startupDisplay.setup(255);
   startupDisplay.setupStartButtonCallback(&startButtonCallback);
+  startupDisplay.setupTelemetry(&telemetry);
   startupDisplay.draw();
-  while (isStartupActive)
+}
+
+// the display settings are applied again because the setup resets the brightness
+void setupDisplay()
+{
+  SpiBusLock lock(&spiBus, SpiBusPriority::DISPLAY, portMAX_DELAY);
+  windSpeedDisplay.setupTelemetry(&telemetry);
+  windSpeedDisplay.setupMetrics(&metrics);
+  windSpeedDisplay.setup();
+  windSpeedDisplay.updateSettings(settings.LowerWindspeedThreshold, settings.UpperWindspeedThreshold, settings.WindspeedEvaluationRange, settings.WindspeedDurationRange, settings.DisplayBrightness);
+}
+
+// the display shares the spi bus with the sd card, a skipped view is drawn with the next sample
+void drawDisplay()
+{
+  SpiBusLock lock(&spiBus, SpiBusPriority::DISPLAY, SPI_BUS_DISPLAY_TIMEOUT);
+  if (lock.isAcquired())
   {
-    delay(1);
-    startupDisplay.evaluateTouches();
+    MetricsTimer timer(&metrics, MetricsTiming::DISPLAY_DRAW);
+    TRACE_SPAN("draw");
+    windSpeedDisplay.draw((DrawType)menuX);
   }
 }
 
@@ -648,28 +1177,104 @@ void switchOnWifi()
   }
 }
 
-void setup(void)
+void setupStorage()
 {
-  // order of initialization is important
-  setupM5();
+  int8_t stage = bootProfiler.beginStage("SDCard");
   windSpeed.setup();
-  setupWindspeedIO();
-  setupSoundModule();
+  bootProfiler.endStage(stage);
+  stage = bootProfiler.beginStage("LittleFS");
   setupLittleFS();
-  setupStartupDisplay();
+  bootProfiler.endStage(stage);
+}
+
+// wifi manager blocks in this task while its config portal is open
+void setupNetwork()
+{
+  int8_t stage = bootProfiler.beginStage("Wifi");
   setupWifi();
-  setupRtc();
+  bootProfiler.endStage(stage);
+  stage = bootProfiler.beginStage("TimeSync");
+  setupTimeSync();
+  bootProfiler.endStage(stage);
+  stage = bootProfiler.beginStage("Server");
   setupServer();
-  windSpeedDisplay.setup();
-  setupPreferences();
+  bootProfiler.endStage(stage);
   if (!isWifiOn)
   {
     switchOffWifi();
   }
 }
 
+void bootTask(void *parameter)
+{
+  const BootTask *task = (const BootTask *)parameter;
+  task->Function();
+  vTaskDelete(NULL);
+}
+
+void startBootTask(const BootTask *task)
+{
+  if (xTaskCreate(bootTask, task->Name, BOOT_TASK_STACK_SIZE, (void *)task, BOOT_TASK_PRIORITY, NULL) != pdPASS)
+  {
+    Serial.printf("Failed to create boot task %s\n", task->Name);
+    task->Function();
+  }
+}
+
+// called from the loop once the start button of the startup display was pressed
+void finishStartup()
+{
+  static const BootTask networkTask = {"Network", &setupNetwork};
+  int8_t stage = bootProfiler.beginStage("Display");
+  setupDisplay();
+  bootProfiler.endStage(stage);
+  isDisplayReady = true;
+  startBootTask(&networkTask);
+}
+
+void setup(void)
+{
+  // the sampling is started first, storage and network are set up in boot tasks
+  static const BootTask storageTask = {"Storage", &setupStorage};
+  spiBus.setup();
+  jsonArenaPool.setup();
+  windSpeed.setupSpiBus(&spiBus);
+  windSpeed.setupMetrics(&metrics);
+  int8_t stage = bootProfiler.beginStage("M5");
+  setupM5();
+  telemetry.update();
+  bootProfiler.endStage(stage);
+  stage = bootProfiler.beginStage("Preferences");
+  setupPreferences();
+  setupCalibration();
+  setupAlarmRules();
+  bootProfiler.endStage(stage);
+  stage = bootProfiler.beginStage("Sampling");
+  setupWindspeedIO();
+  lastMillis = millis();
+  bootProfiler.endStage(stage);
+  stage = bootProfiler.beginStage("Time");
+  setupTime();
+  bootProfiler.endStage(stage);
+  setupSoundModule();
+  playSwitchOnSound();
+  // the sd card shares the spi bus with the display, so it is mounted after the startup display is drawn
+  stage = bootProfiler.beginStage("StartupDisplay");
+  setupStartupDisplay();
+  bootProfiler.endStage(stage);
+  startBootTask(&storageTask);
+}
+
 void startDeepSleep()
 {
+  settingsStore.commit();
+  // the switch off sound is finished before the display and the speaker are switched off,
+  // without it (switched off by a swipe) an active alarm pattern is not waited for
+  while (isSwitchoffSoundActive && soundSequencer.isPlaying())
+  {
+    soundSequencer.update();
+    delay(1);
+  }
   esp_sleep_enable_ext0_wakeup(GPIO_NUM_39, 0); // gpio39 == touch INT
   delay(100);
   M5.Display.fillScreen(TFT_BLACK);
@@ -693,7 +1298,7 @@ void evaluateTouches()
       {
         if (touchDetail.distanceX() > 0)
         {
-          if (menuX == 4)
+          if (menuX == (int)LAST_DRAW_TYPE)
           {
             menuX = 0;
           }
@@ -706,14 +1311,14 @@ void evaluateTouches()
         {
           if (menuX == 0)
           {
-            menuX = 4;
+            menuX = (int)LAST_DRAW_TYPE;
           }
           else
           {
             menuX--;
           }
         }
-        windSpeedDisplay.draw((DrawType)menuX);
+        drawDisplay();
       }
     }
 
@@ -748,8 +1353,35 @@ void evaluateTouches()
 void loop(void)
 {
   M5.delay(1);
-  M5.update();
-  evaluateTouches();
+  MetricsTimer loopTimer(&metrics, MetricsTiming::LOOP);
+  if (isStartupActive)
+  {
+    SpiBusLock lock(&spiBus, SpiBusPriority::DISPLAY, SPI_BUS_DISPLAY_TIMEOUT);
+    if (lock.isAcquired())
+    {
+      startupDisplay.evaluateTouches();
+    }
+  }
+  else
+  {
+    if (!isDisplayReady)
+    {
+      finishStartup();
+    }
+    if (isWifiConfigFinished)
+    {
+      isWifiConfigFinished = false;
+      setupDisplay();
+    }
+    M5.update();
+    evaluateTouches();
+  }
+  timeSync.update();
+  soundSequencer.update();
+  telemetry.update();
+  windSpeed.processPulses();
+  applyPendingSettings();
+  settingsStore.update();
 
   if (touchDuration > 0 && (millis() - touchDuration) > 3000)
   {
@@ -759,8 +1391,20 @@ void loop(void)
   long currentMillis = millis();
   if (currentMillis - lastMillis >= SAMPLE_RATE)
   {
-    windSpeed.calculateWindspeed(true, true);
+    {
+      MetricsTimer timer(&metrics, MetricsTiming::CALCULATE_WINDSPEED);
+      TRACE_SPAN("sample");
+      windSpeed.calculateWindspeed(true, true);
+    }
     lastMillis = currentMillis;
-    windSpeedDisplay.draw((DrawType)menuX);
+    if (isFirstSample)
+    {
+      isFirstSample = false;
+      bootProfiler.mark("FirstSample");
+    }
+    if (isDisplayReady && !isWifiConfigActive)
+    {
+      drawDisplay();
+    }
   }
 }
@@ -0,0 +1,117 @@
+#include <unity.h>
+#include "PulseCapture.h"
+
+#define TEST_DRAIN_INTERVAL 10000 // us, the loop drains the capture about every 10ms
+
+CalibrationCurve calibrationCurve;
+
+// records an edge every period (none if 0) and drains the capture like the loop, returns the end time in us
+uint32_t feedPulseTrain(PulseCapture &capture, uint32_t start, uint32_t duration, uint32_t period)
+{
+    uint32_t nextEdge = start + period;
+    uint32_t nextDrain = start + TEST_DRAIN_INTERVAL;
+    uint32_t end = start + duration;
+    while (nextDrain <= end)
+    {
+        while (period > 0 && nextEdge <= nextDrain)
+        {
+            capture.recordEdge(nextEdge);
+            nextEdge += period;
+        }
+        capture.process(nextDrain);
+        nextDrain += TEST_DRAIN_INTERVAL;
+    }
+    return end;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_steady_pulse_train()
+{
+    PulseCapture capture(&calibrationCurve);
+    feedPulseTrain(capture, 0, 4000000, 10000);
+    TEST_ASSERT_UINT32_WITHIN(1000, 100000, capture.getInstantFrequency());
+    TEST_ASSERT_UINT32_WITHIN(1000, 100000, capture.getPeakFrequency());
+    TEST_ASSERT_UINT32_WITHIN(1000, 100000, capture.getGustFrequency());
+    TEST_ASSERT_EQUAL_UINT32(0, capture.getGlitchCount());
+    TEST_ASSERT_EQUAL_UINT32(0, capture.getOverrunCount());
+}
+
+void test_no_gust_before_a_whole_gust_range()
+{
+    PulseCapture capture(&calibrationCurve);
+    feedPulseTrain(capture, 0, 2000000, 10000);
+    TEST_ASSERT_UINT32_WITHIN(1000, 100000, capture.getPeakFrequency());
+    TEST_ASSERT_EQUAL_UINT32(0, capture.getGustFrequency());
+}
+
+// 100 edges of a 0.5s burst at 200Hz are a 3s mean of 33.3Hz
+void test_burst_after_calm()
+{
+    PulseCapture capture(&calibrationCurve);
+    uint32_t time = feedPulseTrain(capture, 0, 10000000, 0);
+    time = feedPulseTrain(capture, time, 500000, 5000);
+    feedPulseTrain(capture, time, 4000000, 0);
+    TEST_ASSERT_UINT32_WITHIN(2000, 200000, capture.getPeakFrequency());
+    TEST_ASSERT_UINT32_WITHIN(500, 33333, capture.getGustFrequency());
+}
+
+void test_glitches_are_rejected()
+{
+    PulseCapture capture(&calibrationCurve);
+    uint32_t time = 0;
+    for (uint32_t i = 0; i < 400; i++)
+    {
+        time += 10000;
+        capture.recordEdge(time);
+        capture.recordEdge(time + 200); // contact bounce
+        capture.process(time + 300);
+    }
+    TEST_ASSERT_EQUAL_UINT32(400, capture.getGlitchCount());
+    TEST_ASSERT_EQUAL_UINT32(400, capture.getEdgeCount());
+    TEST_ASSERT_UINT32_WITHIN(1000, 100000, capture.getPeakFrequency());
+    TEST_ASSERT_UINT32_WITHIN(1000, 100000, capture.getGustFrequency());
+}
+
+void test_overrun_of_a_stalled_consumer()
+{
+    PulseCapture capture(&calibrationCurve);
+    for (uint32_t i = 1; i <= PULSE_CAPTURE_BUFFER_SIZE + 10; i++)
+    {
+        capture.recordEdge(i * 2000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, capture.getOverrunCount());
+    capture.process((PULSE_CAPTURE_BUFFER_SIZE + 10) * 2000);
+    capture.recordEdge((PULSE_CAPTURE_BUFFER_SIZE + 11) * 2000);
+    TEST_ASSERT_EQUAL_UINT32(10, capture.getOverrunCount());
+}
+
+// 3s at 285Hz (about 25m/s) fit into the buffer of a loop stalled for 3s
+void test_stalled_loop_at_maximum_windspeed()
+{
+    PulseCapture capture(&calibrationCurve);
+    for (uint32_t i = 1; i <= 3 * 285; i++)
+    {
+        capture.recordEdge(i * 3509);
+    }
+    capture.process(3000000);
+    TEST_ASSERT_EQUAL_UINT32(0, capture.getOverrunCount());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_pulse_train);
+    RUN_TEST(test_no_gust_before_a_whole_gust_range);
+    RUN_TEST(test_burst_after_calm);
+    RUN_TEST(test_glitches_are_rejected);
+    RUN_TEST(test_overrun_of_a_stalled_consumer);
+    RUN_TEST(test_stalled_loop_at_maximum_windspeed);
+    return UNITY_END();
+}